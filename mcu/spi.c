@@ -57,6 +57,70 @@ unsigned char readWriteSPI2(unsigned char txData)
 	return rxData;
 }
 
+// Switch between 8 bit (wide = 0) and 16 bit frames. DFF may only be
+// changed while the SPI is idle and disabled, so pending bytes are sent first.
+void setFrameSizeSPI2(uint8_t wide)
+{
+	uint16_t dff = wide ? SPI_CR1_DFF : 0;
+
+	if ((SPI1->CR1 & SPI_CR1_DFF) == dff)
+		return;
+
+	flushSPI2();
+	SPI1->CR1 &= ~SPI_CR1_SPE;
+	SPI1->CR1 = (SPI1->CR1 & ~SPI_CR1_DFF) | dff;
+	SPI1->CR1 |= SPI_CR1_SPE;
+}
+
+// Transmit-only streaming: feed DR as soon as TXE is set and ignore the
+// received bytes. flushSPI2() has to be called before CD/CS is changed.
+void writeSPI2(unsigned char txData)
+{
+	while(!(SPI1->SR & SPI_SR_TXE));
+	SPI1->DR = txData;
+}
+
+// Transmit-only streaming of one 16 bit frame, see setFrameSizeSPI2()
+void writeWordSPI2(uint16_t txData)
+{
+	while(!(SPI1->SR & SPI_SR_TXE));
+	SPI1->DR = txData;
+}
+
+// End a write-only burst: wait until the last byte is out, then drop the
+// received byte and clear the overrun flag (DR read followed by SR read)
+void flushSPI2(void)
+{
+	while(!(SPI1->SR & SPI_SR_TXE));
+	while(SPI1->SR & SPI_SR_BSY);
+	(void)SPI1->DR;
+	(void)SPI1->SR;
+}
+
+// Stream RGB565 pixels, one 16 bit frame per pixel
+void writePixelsSPI2(const uint16_t *pixels, uint32_t count)
+{
+	setFrameSizeSPI2(1);
+	while(count--)
+	{
+		while(!(SPI1->SR & SPI_SR_TXE));
+		SPI1->DR = *pixels++;
+	}
+	flushSPI2();
+}
+
+// Stream one RGB565 colour count times
+void fillPixelsSPI2(uint16_t colour, uint32_t count)
+{
+	setFrameSizeSPI2(1);
+	while(count--)
+	{
+		while(!(SPI1->SR & SPI_SR_TXE));
+		SPI1->DR = colour;
+	}
+	flushSPI2();
+}
+
 void initCS_Pin(void)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
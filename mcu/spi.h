@@ -14,9 +14,16 @@
 #ifndef __SPI_H
 #define __SPI_H
 
+#include <stdint.h>
 
 void initSPI2(void);
 unsigned char readWriteSPI2(unsigned char txData);
+void setFrameSizeSPI2(uint8_t wide);
+void writeSPI2(unsigned char txData);
+void writeWordSPI2(uint16_t txData);
+void flushSPI2(void);
+void writePixelsSPI2(const uint16_t *pixels, uint32_t count);
+void fillPixelsSPI2(uint16_t colour, uint32_t count);
 
 //Example of CS use
 void initCS_Pin(void);
@@ -0,0 +1,204 @@
+#include "spidma.h"
+#include "spi.h"
+#include "mcu.h"
+
+#define SPI_DMA_QUEUE_LEN	8
+#define SPI_DMA_MAX_COUNT	0xFFFF
+
+// Internal flag, the job repeats its fill value
+#define SPI_DMA_FILL		0x80
+
+typedef struct
+{
+	const void *buffer;
+	uint16_t count;
+	uint16_t fill;
+	uint8_t flags;
+	SpiDmaCallback callback;
+}SpiDmaJob;
+
+// Jobs from queueHead up to queueTail are waiting, queueHead is the one on the bus
+static SpiDmaJob queue[SPI_DMA_QUEUE_LEN];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+static volatile uint8_t dmaActive = 0;
+
+static SpiDmaClock sleepClock = 0;
+static uint32_t sleepTime = 0;
+
+void initDmaSPI2(void)
+{
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	// SPI1_TX is served by DMA1 channel 3
+	DMA1_Channel3->CCR = 0;
+	DMA1_Channel3->CPAR = (uint32_t)&SPI1->DR;
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel3_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	SPI1->CR2 |= SPI_CR2_TXDMAEN;
+}
+
+static void startJob(void)
+{
+	SpiDmaJob *job = &queue[queueHead];
+	uint32_t ccr = DMA_CCR1_DIR | DMA_CCR1_TCIE | DMA_CCR1_PL_1;
+
+	setFrameSizeSPI2(job->flags & SPI_DMA_16BIT);
+	if (job->flags & SPI_DMA_SELECT)
+		device_Select();
+
+	if (job->flags & SPI_DMA_16BIT)
+		ccr |= DMA_CCR1_PSIZE_0 | DMA_CCR1_MSIZE_0;
+
+	if (job->flags & SPI_DMA_FILL)
+	{
+		DMA1_Channel3->CMAR = (uint32_t)&job->fill;
+	}
+	else
+	{
+		DMA1_Channel3->CMAR = (uint32_t)job->buffer;
+		ccr |= DMA_CCR1_MINC;
+	}
+
+	DMA1_Channel3->CNDTR = job->count;
+	DMA1_Channel3->CCR = ccr;
+	DMA1_Channel3->CCR = ccr | DMA_CCR1_EN;
+}
+
+static void queueJob(const void *buffer, uint16_t fill, uint32_t count, uint8_t flags, SpiDmaCallback callback)
+{
+	const uint8_t *data = buffer;
+	uint8_t size = (flags & SPI_DMA_16BIT) ? 2 : 1;
+	uint16_t chunk;
+	uint8_t next;
+	SpiDmaJob *job;
+
+	while(count)
+	{
+		chunk = (count > SPI_DMA_MAX_COUNT) ? SPI_DMA_MAX_COUNT : count;
+		count -= chunk;
+
+		// sleep until the interrupt frees a slot
+		dmaWaitQueuedSPI2(SPI_DMA_QUEUE_LEN - 2);
+		next = (queueTail + 1) % SPI_DMA_QUEUE_LEN;
+
+		job = &queue[queueTail];
+		job->buffer = data;
+		job->count = chunk;
+		job->fill = fill;
+		job->flags = flags;
+		job->callback = count ? 0 : callback;
+
+		if (!(flags & SPI_DMA_FILL))
+			data += (uint32_t)chunk * size;
+
+		__disable_irq();
+		queueTail = next;
+		if (!dmaActive)
+		{
+			dmaActive = 1;
+			startJob();
+		}
+		__enable_irq();
+	}
+}
+
+void dmaWriteSPI2(const void *buffer, uint32_t count, uint8_t flags, SpiDmaCallback callback)
+{
+	queueJob(buffer, 0, count, flags & ~SPI_DMA_FILL, callback);
+}
+
+void dmaFillSPI2(uint16_t value, uint32_t count, uint8_t flags, SpiDmaCallback callback)
+{
+	queueJob(0, value, count, flags | SPI_DMA_FILL, callback);
+}
+
+uint8_t dmaBusySPI2(void)
+{
+	return dmaActive;
+}
+
+uint8_t dmaQueuedSPI2(void)
+{
+	return (queueTail + SPI_DMA_QUEUE_LEN - queueHead) % SPI_DMA_QUEUE_LEN;
+}
+
+// Sleep until at most jobs transfers are queued. The interrupts are off
+// between the check and WFI, so the transfer complete interrupt cannot
+// slip in unnoticed, and WFI still wakes up on it.
+void dmaWaitQueuedSPI2(uint8_t jobs)
+{
+	uint32_t start = 0;
+	uint8_t slept = 0;
+
+	if (sleepClock)
+		start = sleepClock();
+	__disable_irq();
+	while(dmaQueuedSPI2() > jobs)
+	{
+		__WFI();
+		__enable_irq();
+		slept = 1;
+		__disable_irq();
+	}
+	__enable_irq();
+	if (slept && sleepClock)
+		sleepTime += sleepClock() - start;
+}
+
+void dmaWaitSPI2(void)
+{
+	dmaWaitQueuedSPI2(0);
+}
+
+void dmaSetClockSPI2(SpiDmaClock clock)
+{
+	sleepClock = clock;
+}
+
+uint32_t dmaSleepSPI2(void)
+{
+	return sleepTime;
+}
+
+void DMA1_Channel3_IRQHandler(void)
+{
+	SpiDmaCallback callback;
+	uint8_t flags;
+
+	if (DMA1->ISR & DMA_ISR_TCIF3)
+	{
+		DMA1->IFCR = DMA_IFCR_CGIF3;
+		DMA1_Channel3->CCR &= ~DMA_CCR1_EN;
+
+		// the last frame is still being shifted out
+		while(!(SPI1->SR & SPI_SR_TXE));
+		while(SPI1->SR & SPI_SR_BSY);
+
+		// drop the received garbage and clear the overrun it caused
+		(void)SPI1->DR;
+		(void)SPI1->SR;
+
+		callback = queue[queueHead].callback;
+		flags = queue[queueHead].flags;
+		queueHead = (queueHead + 1) % SPI_DMA_QUEUE_LEN;
+
+		if ((flags & SPI_DMA_SELECT) && (queueHead == queueTail || !(queue[queueHead].flags & SPI_DMA_SELECT)))
+			device_Unselect();
+
+		if (queueHead != queueTail)
+			startJob();
+		else
+			dmaActive = 0;
+
+		if (callback)
+			callback();
+	}
+}
@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * @file    firmware/src/mcu/spidma.h
+  * @brief   DMA driven SPI1 transmit queue.
+  ******************************************************************************
+  */
+
+#ifndef __SPIDMA_H
+#define __SPIDMA_H
+
+#include <stdint.h>
+
+// Send 16 bit frames (RGB565 pixels) instead of bytes
+#define SPI_DMA_16BIT	0x01
+// Hold CS low while the job is on the bus. It is released after the last
+// of back to back selecting jobs, in the interrupt that finishes it.
+#define SPI_DMA_SELECT	0x02
+
+typedef void (*SpiDmaCallback)(void);
+// Free running time source, e.g. core cycles, used to measure the waits
+typedef uint32_t (*SpiDmaClock)(void);
+
+void initDmaSPI2(void);
+
+// Queue a buffer / a repeated value for transmission. The call only blocks
+// while the queue is full, the buffer must stay valid until the transfer
+// is done (callback or dmaBusySPI2() returning 0).
+void dmaWriteSPI2(const void *buffer, uint32_t count, uint8_t flags, SpiDmaCallback callback);
+void dmaFillSPI2(uint16_t value, uint32_t count, uint8_t flags, SpiDmaCallback callback);
+
+uint8_t dmaBusySPI2(void);
+uint8_t dmaQueuedSPI2(void);
+void dmaWaitQueuedSPI2(uint8_t jobs);
+void dmaWaitSPI2(void);
+
+// Time spent asleep in the waits above, in ticks of the clock set by
+// dmaSetClockSPI2(). It wraps around, take differences. Nothing is
+// counted while no clock is set.
+void dmaSetClockSPI2(SpiDmaClock clock);
+uint32_t dmaSleepSPI2(void);
+
+#endif
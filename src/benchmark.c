@@ -0,0 +1,360 @@
+/*
+ * benchmark.c
+ *
+ * On-target benchmarks, only built when BENCHMARK is defined. The results
+ * are printed on the LCD, one per text row, and the firmware stops there.
+ */
+
+#ifdef BENCHMARK
+
+#include <stdio.h>
+#include "benchmark.h"
+#include "ili9163.h"
+#include "spi.h"
+#include "spidma.h"
+#include "stats.h"
+#include "input.h"
+#include "stm32l1xx.h"
+
+// DWT cycle counter (not described by this CMSIS version)
+#define DWT_CTRL	(*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT	(*(volatile uint32_t *)0xE0001004)
+
+#define BENCH_SPI_BYTES	(128 * 128 * 2)
+// Largest value of the 6 character score, lines and time fields
+#define BENCH_FORMAT_MAX	999999
+
+#define BENCH_ROWS	16
+#define BENCH_PAGE_SECONDS	5
+
+// Printed results of the current page, kept to print them again after a
+// benchmark clears the screen. A full page stays for BENCH_PAGE_SECONDS.
+static char benchLines[BENCH_ROWS][22];
+static uint8_t benchRow = 0;
+
+static void benchInit(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= 1;
+}
+
+static uint32_t benchPerSecond(uint32_t amount, uint32_t cycles)
+{
+	return (uint64_t)amount * SystemCoreClock / cycles;
+}
+
+static void benchPrint(const char *label, uint32_t value)
+{
+	uint32_t start;
+
+	if (benchRow == BENCH_ROWS)
+	{
+		start = DWT_CYCCNT;
+		for (int i = 0; i < BENCH_PAGE_SECONDS; i++)
+		{
+			while (DWT_CYCCNT - start < SystemCoreClock);
+			start += SystemCoreClock;
+		}
+		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+		benchRow = 0;
+	}
+	snprintf(benchLines[benchRow], sizeof(benchLines[0]), "%s%lu", label, (unsigned long)value);
+	lcdPutS(benchLines[benchRow], lcdTextX(0), lcdTextY(benchRow), decodeRgbValue(31, 31, 31), decodeRgbValue(0, 0, 0));
+	benchRow++;
+}
+
+// Clear the screen and print the results collected so far again
+static void benchClearScreen(void)
+{
+	lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	for (uint8_t i = 0; i < benchRow; i++)
+		lcdPutS(benchLines[i], lcdTextX(0), lcdTextY(i), decodeRgbValue(31, 31, 31), decodeRgbValue(0, 0, 0));
+}
+
+// Bytes per second of the full duplex path against the transmit-only path
+// and the 16 bit pixel frames, all streaming a black screen into the LCD memory
+static void benchSpi(void)
+{
+	static const uint16_t black[128] = { 0 };
+	uint32_t start, cycles, i;
+
+	lcdSetWindow(0, 0, 128, 128);
+	setFrameSizeSPI2(0);
+	start = DWT_CYCCNT;
+	for (i = 0; i < BENCH_SPI_BYTES; i++)
+		readWriteSPI2(0);
+	cycles = DWT_CYCCNT - start;
+	benchPrint("rw B/s: ", benchPerSecond(BENCH_SPI_BYTES, cycles));
+
+	lcdSetWindow(0, 0, 128, 128);
+	setFrameSizeSPI2(0);
+	start = DWT_CYCCNT;
+	for (i = 0; i < BENCH_SPI_BYTES; i++)
+		writeSPI2(0);
+	flushSPI2();
+	cycles = DWT_CYCCNT - start;
+	benchPrint("tx B/s: ", benchPerSecond(BENCH_SPI_BYTES, cycles));
+
+	lcdSetWindow(0, 0, 128, 128);
+	start = DWT_CYCCNT;
+	for (i = 0; i < BENCH_SPI_BYTES / sizeof(black); i++)
+		writePixelsSPI2(black, 128);
+	cycles = DWT_CYCCNT - start;
+	benchPrint("px16 B/s: ", benchPerSecond(BENCH_SPI_BYTES, cycles));
+}
+
+// Collision tests per second: landing, left, right and rotation checks of
+// every shape at every column and row of a half filled board
+static void benchCollision(void)
+{
+	static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+	uint32_t start, cycles, count = 0;
+	volatile int hit = 0;
+
+	createFrame(board);
+	for (int x = 0; x < BOARD_COLS - 1; x += 2)
+		placeDownBlock(board, x, BOARD_ROWS - 1 - x, 0);
+
+	start = DWT_CYCCNT;
+	for (int c = 0; c < 19; c++)
+		for (int x = 0; x < BOARD_COLS - 3; x++)
+			for (int y = BLOCK_START_Y; y < BOARD_ROWS - 3; y++){
+				hit += checkBlockade(board, x, y, c);
+				hit += checkLeftSide(board, x, y, c);
+				hit += checkRightSide(board, x, y, c);
+				hit += checkRotation(board, x, y, c);
+				count += 4;
+			}
+	cycles = DWT_CYCCNT - start;
+	benchPrint("chk/s: ", benchPerSecond(count, cycles));
+}
+
+// Pixels per second of a whole playfield frame by matrixPlot(), composing
+// and sending overlap, so the time runs until the last line is out
+static void benchPlot(void)
+{
+	static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+	uint32_t start, cycles;
+
+	createFrame(board);
+	for (int x = 0; x < BOARD_COLS - 1; x += 2)
+		placeDownBlock(board, x, BOARD_ROWS - 1 - x, 0);
+
+	markDirty(0, 0, 127, 127);
+	dmaWaitSPI2();
+	start = DWT_CYCCNT;
+	matrixPlot(board, 0);
+	dmaWaitSPI2();
+	cycles = DWT_CYCCNT - start;
+	benchClearScreen();
+	benchPrint("plot px/s: ", benchPerSecond(62 * 128, cycles));
+}
+
+// Cycles of a full screen clear: the old pixel by pixel lcdWriteData()
+// loop, the CPU polled fill, and lcdClearDisplay() with its DMA fill split
+// into the time until the call returns and until the last pixel is out
+static void benchClear(void)
+{
+	uint16_t black = decodeRgbValue(0, 0, 0);
+	uint8_t high = black >> 8, low = black & 0xFF;
+	uint32_t start, pixel, polled, queued, wire;
+
+	dmaWaitSPI2();
+	start = DWT_CYCCNT;
+	lcdSetWindow(0, 0, 128, 128);
+	for (uint32_t i = 0; i < 128 * 128; i++)
+		lcdWriteData(high, low);
+	flushSPI2();
+	pixel = DWT_CYCCNT - start;
+
+	start = DWT_CYCCNT;
+	lcdSetWindow(0, 0, 128, 128);
+	fillPixelsSPI2(black, 128 * 128);
+	polled = DWT_CYCCNT - start;
+
+	start = DWT_CYCCNT;
+	lcdClearDisplay(black);
+	queued = DWT_CYCCNT - start;
+	dmaWaitSPI2();
+	wire = DWT_CYCCNT - start;
+
+	benchClearScreen();
+	benchPrint("clr px cyc: ", pixel);
+	benchPrint("clr cpu cyc: ", polled);
+	benchPrint("clr dma cyc: ", queued);
+	benchPrint("clr wire cyc: ", wire);
+}
+
+// Cycles to render the game over screen through the text buffer, first with
+// an empty glyph cache and then again with the cache filled by the first pass
+static void benchGameOver(void)
+{
+	int highscore[] = {5000, 4000, 3000, 2000, 1000};
+	char *names[] = { "Player1", "Player2", "Player3", "Player4", "Player5" };
+	char alias[7] = "NONAME", score[7] = "1200", time[7] = "95", pm[8] = "757.8   ";
+	uint32_t start, cold, warm, hits, misses;
+
+	lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	dmaWaitSPI2();
+	start = DWT_CYCCNT;
+	drawGameOver(score, 1200, highscore, names, alias, time, pm);
+	textFlush();
+	dmaWaitSPI2();
+	cold = DWT_CYCCNT - start;
+
+	lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	dmaWaitSPI2();
+	start = DWT_CYCCNT;
+	drawGameOver(score, 1200, highscore, names, alias, time, pm);
+	textFlush();
+	dmaWaitSPI2();
+	warm = DWT_CYCCNT - start;
+
+	lcdGlyphStats(&hits, &misses);
+	benchClearScreen();
+	benchPrint("over cold: ", cold);
+	benchPrint("over warm: ", warm);
+	benchPrint("glyph hit: ", hits);
+	benchPrint("glyph miss: ", misses);
+}
+
+// Pixel data bytes of one full playfield frame and of the game over screen
+// in the 16 bpp and the 12 bpp pixel format
+static void benchBytes(void)
+{
+	static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+	static const uint8_t formats[2] = { PIXEL_FORMAT_16BIT, PIXEL_FORMAT_12BIT };
+	int highscore[] = {5000, 4000, 3000, 2000, 1000};
+	char *names[] = { "Player1", "Player2", "Player3", "Player4", "Player5" };
+	char alias[7] = "NONAME", score[7] = "1200", time[7] = "95", pm[8] = "757.8   ";
+	uint32_t start, plot[2], text[2];
+
+	createFrame(board);
+	for (int x = 0; x < BOARD_COLS - 1; x += 2)
+		placeDownBlock(board, x, BOARD_ROWS - 1 - x, 0);
+
+	for (int f = 0; f < 2; f++)
+	{
+		lcdSetPixelFormat(formats[f]);
+		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+
+		markDirty(0, 0, 127, 127);
+		start = lcdPixelBytes();
+		matrixPlot(board, 0);
+		plot[f] = lcdPixelBytes() - start;
+
+		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+		start = lcdPixelBytes();
+		drawGameOver(score, 1200, highscore, names, alias, time, pm);
+		textFlush();
+		text[f] = lcdPixelBytes() - start;
+	}
+
+	dmaWaitSPI2();
+	lcdSetPixelFormat(LCD_PIXEL_FORMAT);
+	benchClearScreen();
+	benchPrint("plot16 B: ", plot[0]);
+	benchPrint("plot12 B: ", plot[1]);
+	benchPrint("text16 B: ", text[0]);
+	benchPrint("text12 B: ", text[1]);
+}
+
+// Key edges found in a synthetic noisy keypad trace: the ladder levels of
+// none, left, none, right, down, none, rotate, none for 200 ticks each,
+// INPUT_ADC_SAMPLES samples per tick with +-40 noise and a +-600 spike in
+// about every 20th sample. The classifier is fed the last raw sample and
+// the median of the tick's samples, the cycles are per median.
+static void benchInput(void)
+{
+	static const int16_t levels[] = { 4000, 2000, 4000, 2800, 3375, 4000, 3585, 4000 };
+	uint16_t samples[INPUT_ADC_SAMPLES];
+	uint32_t seed = 12345, start, cycles = 0, expected = 0, raw = 0, median = 0;
+	uint8_t keyRaw = INPUT_NONE, keyMedian = INPUT_NONE, keyLevel = INPUT_NONE, key;
+	int value;
+
+	for (int l = 0; l < (int)(sizeof(levels) / sizeof(levels[0])); l++)
+	{
+		key = inputClassify(levels[l], INPUT_NONE);
+		expected += (key != keyLevel);
+		keyLevel = key;
+
+		for (int t = 0; t < 200; t++)
+		{
+			for (int i = 0; i < INPUT_ADC_SAMPLES; i++)
+			{
+				seed = seed * 1103515245 + 12345;
+				value = levels[l] + (int)((seed >> 16) % 81) - 40;
+				if ((seed >> 8) % 20 == 0)
+					value += (seed & 1) ? 600 : -600;
+				samples[i] = value < 0 ? 0 : (value > 4095 ? 4095 : value);
+			}
+
+			key = inputClassify(samples[INPUT_ADC_SAMPLES - 1], keyRaw);
+			raw += (key != keyRaw);
+			keyRaw = key;
+
+			start = DWT_CYCCNT;
+			value = inputMedian(samples, INPUT_ADC_SAMPLES);
+			cycles += DWT_CYCCNT - start;
+			key = inputClassify(value, keyMedian);
+			median += (key != keyMedian);
+			keyMedian = key;
+		}
+	}
+	benchPrint("key edges exp: ", expected);
+	benchPrint("key edges raw: ", raw);
+	benchPrint("key edges med: ", median);
+	benchPrint("median cyc: ", cycles / (sizeof(levels) / sizeof(levels[0]) * 200));
+}
+
+// Cycles per call of snprintf() against formatStatsUint() for every value
+// of the 6 digit HUD fields, and the count of values where the two differ
+// (trailing padding of formatStatsUint() ignored). test/test_stats.c also
+// checks the rates against the old float code on the host.
+static void benchFormat(void)
+{
+	char expected[12], actual[12];
+	uint32_t start, mismatches = 0, value;
+	uint64_t cyclesPrintf = 0, cyclesStats = 0;
+	uint8_t length;
+
+	for (value = 0; value <= BENCH_FORMAT_MAX; value++)
+	{
+		start = DWT_CYCCNT;
+		snprintf(expected, sizeof(expected), "%lu", (unsigned long)value);
+		cyclesPrintf += DWT_CYCCNT - start;
+
+		start = DWT_CYCCNT;
+		length = formatStatsUint(actual, sizeof(actual), value);
+		cyclesStats += DWT_CYCCNT - start;
+
+		actual[length] = '\0';
+		for (int i = 0; i <= length; i++)
+			if (actual[i] != expected[i])
+			{
+				mismatches++;
+				break;
+			}
+	}
+	benchPrint("printf cyc: ", cyclesPrintf / (BENCH_FORMAT_MAX + 1));
+	benchPrint("fmt cyc: ", cyclesStats / (BENCH_FORMAT_MAX + 1));
+	benchPrint("fmt diff: ", mismatches);
+}
+
+void runBenchmarks(void)
+{
+	benchInit();
+	benchPlot();
+	benchClear();
+	benchGameOver();
+	benchBytes();
+	benchSpi();
+	benchCollision();
+	benchFormat();
+	benchInput();
+
+	while (1);
+}
+
+#endif /* BENCHMARK */
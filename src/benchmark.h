@@ -0,0 +1,16 @@
+/*
+ * benchmark.h
+ *
+ * On-target benchmarks, only built when BENCHMARK is defined.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+
+#ifdef BENCHMARK
+void runBenchmarks(void);
+#endif
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,18 @@
+/*
+ * events.h
+ *
+ * Event flags set by the interrupts, the main loop sleeps until one is set.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdint.h>
+
+#define EVENT_TICK		0x01	// SysTick, 1 ms passed
+#define EVENT_INPUT		0x02	// a key event was queued, see input.h
+
+extern volatile uint8_t gEvents;
+extern volatile uint32_t gTicks;
+
+#endif /* EVENTS_H_ */
@@ -2,28 +2,27 @@
 #include "ili9163.h"
 #include "font5x8.h"
 #include "spi.h"
+#include "spidma.h"
 #include "ssd1306.h"
+#include "stats.h"
+#include "input.h"
 #include "stm32l1xx.h"
 #include <stdio.h>
 
-uint16_t matrix_pom[128][128];
 // Low-level LCD driving functions --------------------------------------------------------------------------
 
-// Funkcia potrebne pre spustenie prerusenia
+// Funkcia potrebne pre spustenie prerusenia, ADC uz nepouziva prerusenie (DMA)
 void startupNVIC(){
 	NVIC_PriorityGroupConfig(NVIC_PriorityGroup_0);
-	NVIC_InitTypeDef NVIC_InitStructure;
-	NVIC_InitStructure.NVIC_IRQChannel = ADC1_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 2;
-	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
-	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
-	NVIC_Init(&NVIC_InitStructure);
 }
 
 // Funkcia potrebne pre ADC
+// ADC meria stale dookola a DMA1 kanal 1 zapisuje vysledky do kruhoveho buffera gAdcSamples,
+// bez prerusenia po kazdom prevode. SysTick z buffera berie median (pozri input.c).
 void adc_init(void){
   GPIO_InitTypeDef GPIO_InitStructure;
   ADC_InitTypeDef ADC_InitStructure;
+  DMA_InitTypeDef DMA_InitStructure;
   RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA, ENABLE);
   GPIO_InitStructure.GPIO_Pin = GPIO_Pin_0 ;
   GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AN;
@@ -31,6 +30,21 @@ void adc_init(void){
   GPIO_Init(GPIOA, &GPIO_InitStructure);
   RCC_HSICmd(ENABLE);
   while(RCC_GetFlagStatus(RCC_FLAG_HSIRDY) == RESET);
+  RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+  DMA_DeInit(DMA1_Channel1);
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;
+  DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)gAdcSamples;
+  DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+  DMA_InitStructure.DMA_BufferSize = INPUT_ADC_SAMPLES;
+  DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+  DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+  DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_Low;
+  DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+  DMA_Init(DMA1_Channel1, &DMA_InitStructure);
+  DMA_Cmd(DMA1_Channel1, ENABLE);
   RCC_APB2PeriphClockCmd(RCC_APB2Periph_ADC1, ENABLE);
   ADC_StructInit(&ADC_InitStructure);
   ADC_InitStructure.ADC_Resolution = ADC_Resolution_12b;
@@ -39,7 +53,9 @@ void adc_init(void){
   ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
   ADC_InitStructure.ADC_NbrOfConversion = 1;
   ADC_Init(ADC1, &ADC_InitStructure);
-  ADC_RegularChannelConfig(ADC1, ADC_Channel_0, 1, ADC_SampleTime_96Cycles);
+  ADC_RegularChannelConfig(ADC1, ADC_Channel_0, 1, ADC_SampleTime_384Cycles);
+  ADC_DMARequestAfterLastTransferCmd(ADC1, ENABLE);
+  ADC_DMACmd(ADC1, ENABLE);
   ADC_Cmd(ADC1, ENABLE);
   while(ADC_GetFlagStatus(ADC1, ADC_FLAG_ADONS) == RESET){}
   ADC_SoftwareStartConv(ADC1);
@@ -58,24 +74,32 @@ void lcdReset(void)
 
 void lcdWriteCommand(uint8_t address)
 {
+	// CD may only change once the queued pixel data and parameters are out
+	dmaWaitSPI2();
+	setFrameSizeSPI2(0);
+	flushSPI2();
 	cd_reset();
 
-	readWriteSPI2(address);
+	writeSPI2(address);
+	flushSPI2();
 }
 
 void lcdWriteParameter(uint8_t parameter)
 {
+	dmaWaitSPI2();
 	cd_set();
 
-	readWriteSPI2(parameter);
+	writeSPI2(parameter);
 }
 
+// Pixel data is sent as one 16 bit frame per pixel
 void lcdWriteData(uint8_t dataByte1, uint8_t dataByte2)
 {
+	dmaWaitSPI2();
+	setFrameSizeSPI2(1);
 	cd_set();
 
-	readWriteSPI2(dataByte1);
-	readWriteSPI2(dataByte2);
+	writeWordSPI2((dataByte1 << 8) | dataByte2);
 }
 
 // Initialise the display with the require screen orientation
@@ -90,8 +114,7 @@ void lcdInitialise(uint8_t orientation)
     lcdWriteCommand(EXIT_SLEEP_MODE);
     Delay(10000); // Wait for the screen to wake up
 
-    lcdWriteCommand(SET_PIXEL_FORMAT);
-    lcdWriteParameter(0x05); // 16 bits per pixel
+    lcdSetPixelFormat(LCD_PIXEL_FORMAT); // 16 or 12 bits per pixel
 
     lcdWriteCommand(SET_GAMMA_CURVE);
     lcdWriteParameter(0x04); // Select gamma curve 3
@@ -176,69 +199,234 @@ void lcdInitialise(uint8_t orientation)
 }
 
 // LCD graphics functions -----------------------------------------------------------------------------------
-void lcdClearDisplay(uint16_t colour)
+
+// Pixels are packed into chunks of this many pixels in 12 bpp mode
+#define PACK_PIXELS		128
+
+static uint8_t pixelFormat = PIXEL_FORMAT_16BIT;
+static uint32_t pixelBytes = 0;
+
+// Select 16 bpp (RGB565) or 12 bpp (RGB444) transfers. The pixel buffers
+// and colours stay RGB565, in 12 bpp mode they are packed while being sent.
+void lcdSetPixelFormat(uint8_t format)
 {
-	uint16_t pixel;
+	lcdWriteCommand(SET_PIXEL_FORMAT);
+	lcdWriteParameter(format);
+	pixelFormat = format;
+}
 
-	// Set the column address to 0-127
-	lcdWriteCommand(SET_COLUMN_ADDRESS);
-	    lcdWriteParameter(0x20); // XSH
-	    lcdWriteParameter(0x00); // XSL
-	    lcdWriteParameter(0x20); // XEH
-	    lcdWriteParameter(0x7f); // XEL (128 pixels x)
-
-	    lcdWriteCommand(SET_PAGE_ADDRESS);
-	    lcdWriteParameter(0x00);
-	    lcdWriteParameter(0x20);
-	    lcdWriteParameter(0x00);
-	    lcdWriteParameter(0xA0); // 128 pixels y
-
-	// Plot the pixels
-	lcdWriteCommand(WRITE_MEMORY_START);
-	for(pixel = 0; pixel < 16385; pixel++) lcdWriteData(colour >> 8, colour);
+// Count of pixel data bytes sent since start-up
+uint32_t lcdPixelBytes(void)
+{
+	return pixelBytes;
 }
 
-// LCD text manipulation functions --------------------------------------------------------------------------
-#define pgm_read_byte_near(address_short) (uint16_t)(address_short)
-// Plot a character at the specified x, y co-ordinates (top left hand corner of character)
-void lcdPutCh(unsigned char character, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour)
+// Reduce an RGB565 colour to 12 bits, the top 4 bits of every component
+static uint16_t lcdPixel12(uint16_t colour)
 {
-	uint8_t row, column;
+	return ((colour >> 4) & 0xF00) | ((colour >> 3) & 0x0F0) | ((colour >> 1) & 0x00F);
+}
+
+// Queue count pixels of the current window. In 12 bpp mode they are packed
+// chunk by chunk into two alternating buffers, so the source buffer is free
+// on return. Only the last pixels of a window may have an odd count, the
+// last pixel is then padded to two bytes.
+static void lcdSendPixels(const uint16_t *pixels, uint32_t count)
+{
+	static uint8_t packed[2][PACK_PIXELS * 3 / 2];
+	static uint8_t next = 0;
+	uint32_t chunk, i;
+	uint16_t p0, p1;
+	uint8_t *out;
+
+	if (pixelFormat == PIXEL_FORMAT_16BIT)
+	{
+		dmaWriteSPI2(pixels, count, SPI_DMA_16BIT, 0);
+		pixelBytes += count * 2;
+		return;
+	}
+
+	while (count)
+	{
+		chunk = (count > PACK_PIXELS) ? PACK_PIXELS : count;
+		count -= chunk;
+		out = packed[next];
 
-	// To speed up plotting we define a x window of 6 pixels and then
-	// write out one row at a time.  This means the LCD will correctly
-	// update the memory pointer saving us a good few bytes
+		// The buffer is free once only the other one can still be queued
+		dmaWaitQueuedSPI2(1);
 
-	lcdWriteCommand(SET_COLUMN_ADDRESS); // Horizontal Address Start Position
+		for (i = 0; i + 1 < chunk; i += 2)
+		{
+			p0 = lcdPixel12(pixels[i]);
+			p1 = lcdPixel12(pixels[i + 1]);
+			*out++ = p0 >> 4;
+			*out++ = (p0 << 4) | (p1 >> 8);
+			*out++ = p1;
+		}
+		if (i < chunk)
+		{
+			p0 = lcdPixel12(pixels[i]);
+			*out++ = p0 >> 4;
+			*out++ = p0 << 4;
+		}
+
+		dmaWriteSPI2(packed[next], out - packed[next], 0, 0);
+		pixelBytes += out - packed[next];
+		pixels += chunk;
+		next ^= 1;
+	}
+}
+
+// Set the address window to w x h pixels with the top left corner at x, y
+// and leave the LCD waiting for pixel data. In 16 bpp mode the SPI is
+// switched to 16 bit frames, lcdWriteCommand() switches it back to 8 bits.
+void lcdSetWindow(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+	lcdWriteCommand(SET_COLUMN_ADDRESS);
 	lcdWriteParameter(0x20);
 	lcdWriteParameter(x);
 	lcdWriteParameter(0x20);
-	lcdWriteParameter(x+5);
+	lcdWriteParameter(x + w - 1);
 
-	lcdWriteCommand(SET_PAGE_ADDRESS); // Vertical Address end Position
+	// Visible rows start at page 32 of the controller memory
+	lcdWriteCommand(SET_PAGE_ADDRESS);
 	lcdWriteParameter(0x00);
-	lcdWriteParameter(y+32);
+	lcdWriteParameter(y + 32);
 	lcdWriteParameter(0x00);
-	lcdWriteParameter(0xA0);
+	lcdWriteParameter(y + h - 1 + 32);
 
 	lcdWriteCommand(WRITE_MEMORY_START);
+	if (pixelFormat == PIXEL_FORMAT_16BIT)
+		setFrameSizeSPI2(1);
+	cd_set();
+}
+
+// Write a w x h block of pixels (row by row) with the top left corner at x, y.
+// The pixels are sent by DMA, in 16 bpp mode the buffer must not change
+// until dmaBusySPI2() is 0
+void lcdWriteRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *pixels)
+{
+	lcdSetWindow(x, y, w, h);
+	lcdSendPixels(pixels, (uint32_t)w * h);
+}
+
+// Fill a w x h block with one colour, returns while the DMA is still sending.
+// In 12 bpp mode grey colours pack into three equal bytes and are still one
+// DMA fill, other colours are packed from a line of the colour.
+void lcdFillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t colour)
+{
+	static uint16_t line[PACK_PIXELS];
+	uint32_t count = (uint32_t)w * h, chunk;
+	uint16_t packed = lcdPixel12(colour);
+
+	lcdSetWindow(x, y, w, h);
+	if (pixelFormat == PIXEL_FORMAT_16BIT)
+	{
+		dmaFillSPI2(colour, count, SPI_DMA_16BIT, 0);
+		pixelBytes += count * 2;
+	}
+	else if ((packed >> 8) == (packed & 0xF) && ((packed >> 4) & 0xF) == (packed & 0xF))
+	{
+		dmaFillSPI2(packed & 0xFF, (count * 3 + 1) / 2, 0, 0);
+		pixelBytes += (count * 3 + 1) / 2;
+	}
+	else
+	{
+		for (chunk = 0; chunk < PACK_PIXELS; chunk++)
+			line[chunk] = colour;
+		while (count)
+		{
+			chunk = (count > PACK_PIXELS) ? PACK_PIXELS : count;
+			lcdSendPixels(line, chunk);
+			count -= chunk;
+		}
+	}
+}
+
+// Clear the screen, the text buffer is reset to blank cells to match it.
+// The fill runs on DMA, the call returns once it is queued.
+void lcdClearDisplay(uint16_t colour)
+{
+	lcdFillRect(0, 0, 128, 128, colour);
+	textClear();
+}
+
+// LCD text manipulation functions --------------------------------------------------------------------------
+#define pgm_read_byte_near(address_short) (uint16_t)(address_short)
+// Glyph cache: ready to send 6x8 RGB565 bitmaps of the most recently used
+// (character, fg, bg) combinations, GLYPH_CACHE_SIZE * 96 bytes of pixels.
+// It holds more than one text line (21 characters), so the glyphs of a
+// line being sent by lcdPutRun() are never evicted by the same line.
+#define GLYPH_CACHE_SIZE	24
+
+typedef struct {
+	uint32_t age;			// 0 = empty, otherwise the time of the last use
+	uint16_t fgColour, bgColour;
+	unsigned char character;
+	uint16_t pixels[6 * 8];
+} GlyphEntry;
+
+static GlyphEntry glyphCache[GLYPH_CACHE_SIZE];
+static uint32_t glyphClock = 0;
+static uint32_t glyphHits = 0, glyphMisses = 0;
+
+// Return the bitmap of a character, expanding it into the least recently
+// used entry on a miss
+static const uint16_t *lcdGlyph(unsigned char character, uint16_t fgColour, uint16_t bgColour)
+{
+	GlyphEntry *entry, *victim = &glyphCache[0];
+	uint8_t row, column;
+
+	glyphClock++;
+	for (entry = glyphCache; entry < glyphCache + GLYPH_CACHE_SIZE; entry++)
+	{
+		if (entry->age && entry->character == character && entry->fgColour == fgColour && entry->bgColour == bgColour)
+		{
+			entry->age = glyphClock;
+			glyphHits++;
+			return entry->pixels;
+		}
+		if (entry->age < victim->age)
+			victim = entry;
+	}
+	glyphMisses++;
+
+	// The victim may still be streaming out
+	dmaWaitSPI2();
 
-	// Plot the font data
 	for (row = 0; row < 8; row++)
 	{
 		for (column = 0; column < 6; column++)
 		{
 			if ((font5x8[character][column]) & (1 << row))
-				lcdWriteData(fgColour>>8, fgColour);
-			else lcdWriteData(bgColour >> 8, bgColour);
+				victim->pixels[row * 6 + column] = fgColour;
+			else victim->pixels[row * 6 + column] = bgColour;
 		}
 	}
+	victim->character = character;
+	victim->fgColour = fgColour;
+	victim->bgColour = bgColour;
+	victim->age = glyphClock;
+	return victim->pixels;
+}
+
+// Glyph cache hit and miss counters since reset
+void lcdGlyphStats(uint32_t *hits, uint32_t *misses)
+{
+	*hits = glyphHits;
+	*misses = glyphMisses;
+}
+
+// Plot a character at the specified x, y co-ordinates (top left hand corner of character)
+void lcdPutCh(unsigned char character, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour)
+{
+	lcdWriteRect(x, y, 6, 8, lcdGlyph(character, fgColour, bgColour));
 }
 
 // Translates a 3 byte RGB value into a 2 byte value for the LCD (values should be 0-31)
 uint16_t decodeRgbValue(uint8_t r, uint8_t g, uint8_t b)
 {
-	return (b << 11) | (g << 6) | (r);
+	return RGB_VALUE(r, g, b);
 }
 
 // This routine takes a row number from 0 to 20 and
@@ -251,761 +439,515 @@ uint8_t lcdTextX(uint8_t x) { return x*6; }
 // it easy to place text
 uint8_t lcdTextY(uint8_t y) { return y*8; }
 
-// Plot a string of characters to the LCD
+// Plot count characters on one line with a single window. The glyph rows
+// are streamed one pixel line at a time from two alternating line buffers.
+static void lcdPutRun(const char *string, uint8_t count, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour)
+{
+	static uint16_t lines[2][21 * 6];
+	const uint16_t *glyphs[21];
+	uint8_t i, row;
+
+	for (i = 0; i < count; i++)
+		glyphs[i] = lcdGlyph(string[i], fgColour, bgColour);
+
+	lcdSetWindow(x, y, count * 6, 8);
+	for (row = 0; row < 8; row++)
+	{
+		uint16_t *line = lines[row & 1];
+
+		// The line buffer is free once only the previous line is queued
+		dmaWaitQueuedSPI2(1);
+
+		for (i = 0; i < count; i++)
+			memcpy(&line[i * 6], &glyphs[i][row * 6], 6 * sizeof(uint16_t));
+		lcdSendPixels(line, count * 6);
+	}
+}
+
+// Plot a string of characters to the LCD, the string is split into one
+// window per line
 void lcdPutS(const char *string, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour)
 {
-	uint8_t origin = x;
-	uint8_t characterNumber;
+	int origin = x, column = x, line = y;
+	int length = strlen(string);
+	int count;
 
-	for (characterNumber = 0; characterNumber < strlen(string); characterNumber++)
+	while (length > 0)
 	{
 		// Check if we are out of bounds and move to
 		// the next line if we are
-		if (x > 121)
+		if (column > 121)
 		{
-			x = origin;
-			y += 8;
+			column = origin;
+			line += 8;
 		}
 
 		// If we move past the bottom of the screen just exit
-		if (y > 120) break;
+		if (line > 120) break;
+		if (column > 121) continue;
+
+		// Characters that fit on this line
+		count = (121 - column) / 6 + 1;
+		if (count > length)
+			count = length;
 
-		// Plot the current character
-		lcdPutCh(string[characterNumber], x, y, fgColour, bgColour);
-		x += 6;
+		lcdPutRun(string, count, column, line, fgColour, bgColour);
+
+		string += count;
+		length -= count;
+		column += count * 6;
 	}
 }
 
-// Funkcia konvertuje celu maticu na 1D pole a zapise ho do pamati a rozdeluje tvary podla farby
-void matrixPlot(uint16_t matrix[128][128], int cisloTvaru){
-	uint16_t pixels[62 * 128];
-	uint16_t colour;
-	int countPix = 0;
-	for(int i = 0;i < 128; i++){
-		for(int j = 56;j < 118; j++){
-			pixels[countPix] = matrix[j][i];
-			countPix++;
-		}
-	}
-	lcdWriteCommand(SET_COLUMN_ADDRESS); // Horizontal Address Start Position
-	lcdWriteParameter(0x20);
-	lcdWriteParameter(56);
-	lcdWriteParameter(0x20);
-	lcdWriteParameter(117);
+// Text buffer functions ------------------------------------------------------------------------------------
+// Menu screens write into a 21x16 character cell buffer, textFlush() only
+// sends the cells that changed since the last flush.
+static const uint16_t textPalette[TEXT_COLOURS] = {
+	RGB_VALUE(0, 0, 0),
+	(uint16_t)RGB_VALUE(255, 255, 255),
+	RGB_VALUE(31, 0, 0),
+	RGB_VALUE(10, 31, 10),
+	RGB_VALUE(15, 31, 0),
+	RGB_VALUE(31, 31, 0),
+};
+
+static char textChars[TEXT_ROWS][TEXT_COLS];
+static uint8_t textAttrs[TEXT_ROWS][TEXT_COLS];
+static uint32_t textDirty[TEXT_ROWS];
+
+// Forget the buffer contents after the screen was cleared to black
+void textClear(void)
+{
+	memset(textChars, ' ', sizeof(textChars));
+	memset(textAttrs, TEXT_ATTR(TEXT_BLACK, TEXT_BLACK), sizeof(textAttrs));
+	memset(textDirty, 0, sizeof(textDirty));
+}
 
-	lcdWriteCommand(SET_PAGE_ADDRESS); // Vertical Address end Position
-	lcdWriteParameter(56);
-	lcdWriteParameter(0x20);
-	lcdWriteParameter(56);
-	lcdWriteParameter(160);
+// Put a character into the text buffer, attr is TEXT_ATTR(fg, bg)
+void textPutCh(char character, uint8_t column, uint8_t row, uint8_t attr)
+{
+	if (column >= TEXT_COLS || row >= TEXT_ROWS)
+		return;
+	if (textChars[row][column] == character && textAttrs[row][column] == attr)
+		return;
+
+	textChars[row][column] = character;
+	textAttrs[row][column] = attr;
+	textDirty[row] |= 1UL << column;
+}
 
-	lcdWriteCommand(WRITE_MEMORY_START);
+// Put a string into the text buffer, wrapping like lcdPutS()
+void textPutS(const char *string, uint8_t column, uint8_t row, uint8_t attr)
+{
+	uint8_t origin = column;
 
-	for (int x = 0; x < (62 * 128); x++){
-		if (pixels[x] == 0){
-			colour = decodeRgbValue(0, 0, 0);
-		}
-		else if (pixels[x] == 1){
-			if (cisloTvaru == 0)
-				colour = decodeRgbValue(31, 31, 0);
-			if (cisloTvaru == 1 || cisloTvaru == 2)
-				colour = decodeRgbValue(0, 31, 31);
-			if (cisloTvaru == 3 || cisloTvaru == 4)
-				colour = decodeRgbValue(31, 0, 0);
-			if (cisloTvaru == 5 || cisloTvaru == 6)
-				colour = decodeRgbValue(0, 31, 0);
-			if (cisloTvaru == 7 || cisloTvaru == 8 || cisloTvaru == 9 || cisloTvaru == 10)
-				colour = decodeRgbValue(0, 0, 31);
-			if (cisloTvaru == 11 || cisloTvaru == 12 || cisloTvaru == 13 || cisloTvaru == 14)
-				colour = decodeRgbValue(15, 0, 31);
-			if (cisloTvaru == 15 || cisloTvaru == 16 || cisloTvaru == 17 || cisloTvaru == 18)
-				colour = decodeRgbValue(31, 15, 31);
-		}
-		else if (pixels[x] == 2){
-			colour = decodeRgbValue(31, 31, 31);
-		}
-		else if (pixels[x] == 3){
-			colour = decodeRgbValue(31, 31, 0);
-		}
-		else if (pixels[x] == 4){
-			colour = decodeRgbValue(0, 31, 31);
-		}
-		else if (pixels[x] == 5){
-			colour = decodeRgbValue(31, 0, 0);
-		}
-		else if (pixels[x] == 6){
-			colour = decodeRgbValue(0, 31, 0);
-		}
-		else if (pixels[x] == 7){
-			colour = decodeRgbValue(0, 0, 31);
-		}
-		else if (pixels[x] == 8){
-			colour = decodeRgbValue(15, 0, 31);
-		}
-		else if (pixels[x] == 9){
-			colour = decodeRgbValue(31, 15, 31);
+	while (*string)
+	{
+		if (column >= TEXT_COLS)
+		{
+			column = origin;
+			row++;
 		}
-		lcdWriteData(colour >> 8, colour);
+		if (row >= TEXT_ROWS) break;
+
+		textPutCh(*string++, column, row, attr);
+		column++;
 	}
 }
 
-// Funkcia vykresli tvar objeku podla toho, aku farbu zvolime, resp ciernu alebo bielu
-void createDeleteBlock(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru, int volba){
-	// ak objekt je stvorec
-	if (cisloTvaru == 0){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 12; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = volba;
-	}
-	// ak objekt je obdlznik |
-	else if (cisloTvaru == 1){
-		for(int i = 0; i < 6; i++)
-			for(int j = 0; j < 24; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = volba;
-	}
-	// ak objekt je obdlznik _
-	else if (cisloTvaru == 2){
-		for(int i = 0; i < 24; i++)
-			for(int j = 0; j < 6; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = volba;
-	}
-	// ak objekt je Z
-	else if (cisloTvaru == 3){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && i < 12)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je N
-	else if (cisloTvaru == 4){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && j < 12)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j < 12 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je opan Z
-	else if (cisloTvaru == 5){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j < 6 && i < 12)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je opacny N
-	else if (cisloTvaru == 6){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && j < 12)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j < 12 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je L
-	else if (cisloTvaru == 7){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 8){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && i > 11)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je '|
-	else if (cisloTvaru == 9){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 12 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 11)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je ,..
-	else if (cisloTvaru == 10){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je _._
-	else if (cisloTvaru == 11){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && (i > 5 && i < 12))
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je -|
-	else if (cisloTvaru == 12){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if ((j > 5 && j < 12) && (i < 6))
-						matrix[x0 + i][y0 - j] = volba;
-					if (i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je ..,..
-	else if (cisloTvaru == 13){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && (i > 5 && i < 12))
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
-	}
-	// ak objekt je |-
-	else if (cisloTvaru == 14){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if ((j > 5 && j < 12) && (i > 5))
-						matrix[x0 + i][y0 - j] = volba;
+// Send the changed cells to the LCD, neighbouring changed cells with the
+// same attribute go out as one run
+void textFlush(void)
+{
+	for (uint8_t row = 0; row < TEXT_ROWS; row++)
+	{
+		uint8_t column = 0;
+
+		while (textDirty[row])
+		{
+			if (textDirty[row] & (1UL << column))
+			{
+				uint8_t attr = textAttrs[row][column];
+				uint8_t count = 0;
+
+				while (column + count < TEXT_COLS && (textDirty[row] & (1UL << (column + count))) &&
+						textAttrs[row][column + count] == attr)
+				{
+					textDirty[row] &= ~(1UL << (column + count));
+					count++;
 				}
+				lcdPutRun(&textChars[row][column], count, lcdTextX(column), lcdTextY(row),
+						textPalette[attr & 0x0F], textPalette[attr >> 4]);
+				column += count;
 			}
+			else column++;
+		}
 	}
-	// ak objekt je opacny L
-	else if (cisloTvaru == 15){
-		for(int i = 0;i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
+}
+
+// Zoznam obdlznikov hracej plochy, ktore sa zmenili od posledneho vykreslenia (pixely displeja, vratane ramca)
+#define DIRTY_MAX 4
+typedef struct {
+	int16_t x0, y0, x1, y1;
+} DirtyRect;
+
+static DirtyRect dirtyRects[DIRTY_MAX];
+static int dirtyCount = 0;
+
+// Funkcia zaznamena zmeneny obdlznik hracej plochy, prekryvajuce sa obdlzniky spoji do jedneho
+void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
+	int merged = 1;
+
+	if (x0 < 56) x0 = 56;
+	if (x1 > 117) x1 = 117;
+	if (y0 < 0) y0 = 0;
+	if (y1 > 127) y1 = 127;
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	// kym sa novy obdlznik prekryva alebo dotyka niektoreho zo zoznamu, spajame ich
+	while (merged){
+		merged = 0;
+		for (int i = 0; i < dirtyCount; i++){
+			DirtyRect *r = &dirtyRects[i];
+			if (x0 <= r->x1 + 1 && r->x0 <= x1 + 1 && y0 <= r->y1 + 1 && r->y0 <= y1 + 1){
+				if (r->x0 < x0) x0 = r->x0;
+				if (r->y0 < y0) y0 = r->y0;
+				if (r->x1 > x1) x1 = r->x1;
+				if (r->y1 > y1) y1 = r->y1;
+				dirtyRects[i] = dirtyRects[--dirtyCount];
+				merged = 1;
+				break;
 			}
+		}
 	}
-	// ak objekt je ..,
-	else if (cisloTvaru == 16){
-		for(int i = 0;i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i > 11)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
+	// ak je zoznam plny, novy obdlznik sa spoji s poslednym
+	if (dirtyCount == DIRTY_MAX){
+		DirtyRect *r = &dirtyRects[DIRTY_MAX - 1];
+		if (r->x0 < x0) x0 = r->x0;
+		if (r->y0 < y0) y0 = r->y0;
+		if (r->x1 > x1) x1 = r->x1;
+		if (r->y1 > y1) y1 = r->y1;
+		dirtyCount--;
+	}
+	dirtyRects[dirtyCount].x0 = x0;
+	dirtyRects[dirtyCount].y0 = y0;
+	dirtyRects[dirtyCount].x1 = x1;
+	dirtyRects[dirtyCount].y1 = y1;
+	dirtyCount++;
+}
+
+// Popis jedneho tvaru (cisloTvaru 0-18)
+typedef struct {
+	uint8_t rows[4];		// riadky tvaru od spodneho, bit i je bunka v stlpci i zlava
+	uint8_t cells[4][2];	// stlpec a riadok (zdola) kazdej zo styroch buniek
+	uint8_t w, h;			// sirka a vyska v bunkach
+	uint8_t next;			// tvar po otoceni
+	uint8_t colour;			// hodnota bunky po polozeni (3-9), urcuje aj farbu
+} BlockShape;
+
+static const BlockShape blockShapes[19] = {
+	{ { 0x3, 0x3, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } }, 2, 2,  0, 3 },	// stvorec
+	{ { 0x1, 0x1, 0x1, 0x1 }, { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 0, 3 } }, 1, 4,  2, 4 },	// obdlznik |
+	{ { 0xF, 0x0, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 } }, 4, 1,  1, 4 },	// obdlznik _
+	{ { 0x6, 0x3, 0x0, 0x0 }, { { 1, 0 }, { 2, 0 }, { 0, 1 }, { 1, 1 } }, 3, 2,  4, 5 },	// Z
+	{ { 0x1, 0x3, 0x2, 0x0 }, { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } }, 2, 3,  3, 5 },	// N
+	{ { 0x3, 0x6, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 1 } }, 3, 2,  6, 6 },	// opacne Z
+	{ { 0x2, 0x3, 0x1, 0x0 }, { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 0, 2 } }, 2, 3,  5, 6 },	// opacny N
+	{ { 0x3, 0x1, 0x1, 0x0 }, { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 0, 2 } }, 2, 3,  8, 7 },	// L
+	{ { 0x7, 0x4, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 2, 1 } }, 3, 2,  9, 7 },	// _.
+	{ { 0x2, 0x2, 0x3, 0x0 }, { { 1, 0 }, { 1, 1 }, { 0, 2 }, { 1, 2 } }, 2, 3, 10, 7 },	// '|
+	{ { 0x1, 0x7, 0x0, 0x0 }, { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, 3, 2,  7, 7 },	// ,..
+	{ { 0x7, 0x2, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1 } }, 3, 2, 12, 8 },	// _._
+	{ { 0x2, 0x3, 0x2, 0x0 }, { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } }, 2, 3, 13, 8 },	// -|
+	{ { 0x2, 0x7, 0x0, 0x0 }, { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, 3, 2, 14, 8 },	// ..,..
+	{ { 0x1, 0x3, 0x1, 0x0 }, { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 0, 2 } }, 2, 3, 11, 8 },	// |-
+	{ { 0x3, 0x2, 0x2, 0x0 }, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 2 } }, 2, 3, 16, 9 },	// opacny L
+	{ { 0x4, 0x7, 0x0, 0x0 }, { { 2, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } }, 3, 2, 17, 9 },	// ..,
+	{ { 0x1, 0x1, 0x3, 0x0 }, { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 2 } }, 2, 3, 18, 9 },	// |'
+	{ { 0x7, 0x1, 0x0, 0x0 }, { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 0, 1 } }, 3, 2, 15, 9 },	// _.
+};
+
+// Tvary kazdeho objektu: prvy tvar a pocet otoceni
+static const uint8_t blockPieces[7][2] = {
+	{ 0, 1 }, { 1, 2 }, { 3, 2 }, { 5, 2 }, { 7, 4 }, { 11, 4 }, { 15, 4 }
+};
+
+// Farby buniek podla hodnoty bunky: 0 prazdna, 1 aktualny objekt (doplni sa pri vykresleni), 2 ramec, 3-9 polozene objekty
+static const uint16_t cellPalette[16] = {
+	RGB_VALUE(0, 0, 0),
+	RGB_VALUE(0, 0, 0),
+	RGB_VALUE(31, 31, 31),
+	RGB_VALUE(31, 31, 0),
+	RGB_VALUE(0, 31, 31),
+	RGB_VALUE(31, 0, 0),
+	RGB_VALUE(0, 31, 0),
+	RGB_VALUE(0, 0, 31),
+	RGB_VALUE(15, 0, 31),
+	RGB_VALUE(31, 15, 31),
+};
+
+#define CELL_FRAME	2
+
+// Funkcia vrati hodnotu bunky, v jednom bajte su dve bunky po 4 bitoch
+static uint8_t getCell(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int row, int col){
+	return (board[row][col >> 1] >> ((col & 1) * 4)) & 0x0F;
+}
+
+// Funkcia zapise hodnotu bunky
+static void setCell(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int row, int col, uint8_t value){
+	uint8_t shift = (col & 1) * 4;
+	board[row][col >> 1] = (board[row][col >> 1] & ~(0x0F << shift)) | ((value & 0x0F) << shift);
+}
+
+// Funkcia vyplni jeden riadok pixelov hracej plochy aj s ramcom (BOARD_COLS * CELL_SIZE + 2 pixelov)
+static void boardLine(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int y, const uint16_t palette[16], uint16_t *line){
+	uint16_t colour;
+
+	*line++ = palette[CELL_FRAME];
+	for (int col = 0; col < BOARD_COLS; col++){
+		// prazdny riadok nad plochou a spodny ramec
+		if (y < BOARD_Y)
+			colour = palette[0];
+		else if (y >= BOARD_Y + BOARD_ROWS * CELL_SIZE)
+			colour = palette[CELL_FRAME];
+		else
+			colour = palette[getCell(board, (y - BOARD_Y) / CELL_SIZE, col)];
+		for (int k = 0; k < CELL_SIZE; k++)
+			*line++ = colour;
 	}
-	// ak objekt je |'
-	else if (cisloTvaru == 17){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 12 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 11)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
+	*line = palette[CELL_FRAME];
+}
+
+// Funkcia posle na displej iba tie obdlzniky hracej plochy, ktore sa od posledneho volania zmenili
+// Obdlznik sa sklada po riadkoch do dvoch striedajucich sa bufferov, DMA posiela jeden riadok,
+// kym sa sklada dalsi. Farba aktualneho objektu sa urci raz za snimok.
+void matrixPlot(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int cisloTvaru){
+	static uint16_t lines[2][BOARD_COLS * CELL_SIZE + 2];
+	uint16_t palette[16];
+	int next = 0;
+
+	memcpy(palette, cellPalette, sizeof(palette));
+	palette[1] = cellPalette[blockShapes[cisloTvaru].colour];
+
+	for (int r = 0; r < dirtyCount; r++){
+		DirtyRect *rect = &dirtyRects[r];
+
+		// 12 bpp posiela pixely po dvojiciach, riadok obdlznika preto musi mat parnu sirku
+		if ((rect->x1 - rect->x0 + 1) & 1){
+			if (rect->x0 > BOARD_X - 1)
+				rect->x0--;
+			else
+				rect->x1++;
+		}
+
+		lcdSetWindow(rect->x0, rect->y0, rect->x1 - rect->x0 + 1, rect->y1 - rect->y0 + 1);
+		for (int i = rect->y0; i <= rect->y1; i++){
+			// buffer je volny, ked ostava poslat najviac predchadzajuci riadok
+			dmaWaitQueuedSPI2(1);
+			boardLine(board, i, palette, lines[next]);
+			lcdSendPixels(&lines[next][rect->x0 - (BOARD_X - 1)], rect->x1 - rect->x0 + 1);
+			next ^= 1;
+		}
 	}
-	// ak objekt je _.
-	else if (cisloTvaru == 18){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = volba;
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = volba;
-				}
-			}
+	dirtyCount = 0;
+}
+
+// Obsadenost polozenych buniek po riadkoch: stlpec j je bit j + 1, bit 0 a bity 11-15 su ramec
+#define ROW_WALLS	0xF801
+#define ROW_FULL	0xFFFF
+
+static uint16_t boardRows[BOARD_ROWS];
+// Bit i je nastaveny, ak je riadok i plny, nastavuje sa pri polozeni objektu
+static uint32_t fullRows = 0;
+
+// Funkcia zaznamena obdlznik, ktory zabera tvar na pozicii x0, y0 (v pixeloch displeja)
+static void markBlockDirty(int16_t x0, int16_t y0, int cisloTvaru){
+	int w = blockShapes[cisloTvaru].w, h = blockShapes[cisloTvaru].h;
+	markDirty(BOARD_X + x0 * CELL_SIZE, BOARD_Y + (y0 - h + 1) * CELL_SIZE,
+			BOARD_X + (x0 + w) * CELL_SIZE - 1, BOARD_Y + (y0 + 1) * CELL_SIZE - 1);
+}
+
+// Funkcia zapise hodnotu do vsetkych buniek tvaru, bunky nad hracou plochou sa vynechaju
+static void fillBlock(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru, uint8_t value){
+	const BlockShape *shape = &blockShapes[cisloTvaru];
+	for(int k = 0; k < 4; k++)
+		if (y0 - shape->cells[k][1] >= 0)
+			setCell(board, y0 - shape->cells[k][1], x0 + shape->cells[k][0], value);
+}
+
+// Funkcia vrati 1, ak sa tvar na pozicii x0, y0 zmesti do ramca a neprekryva ziadny polozeny objekt
+// Kazdy riadok tvaru sa posunie na stlpec x0 a porovna s obsadenostou riadku, nad plochou je iba ramec
+static int blockFits(int16_t x0, int16_t y0, int cisloTvaru){
+	const uint8_t *rows = blockShapes[cisloTvaru].rows;
+	uint16_t line;
+	for(int j = 0; j < 4 && rows[j]; j++){
+		if (y0 - j >= BOARD_ROWS)
+			line = ROW_FULL;
+		else if (y0 - j < 0)
+			line = ROW_WALLS;
+		else
+			line = boardRows[y0 - j];
+		if (((uint16_t)rows[j] << (x0 + 1)) & line)
+			return 0;
 	}
+	return 1;
+}
+
+// Pozicia a tvar aktualneho objektu, ako bol naposledy vykresleny, shownShape -1 ak ziadny nie je
+static int16_t shownX = 0, shownY = 0;
+static int shownShape = -1;
+
+// Funkcia vykresli tvar objeku podla toho, aku farbu zvolime, resp ciernu alebo bielu
+// Vymazanie sa na displeji prejavi az pri dalsom vykresleni: ak je objekt na tom istom mieste
+// s tym istym tvarom, nic sa neoznaci, inak sa oznaci stara aj nova pozicia
+void createDeleteBlock(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru, int volba){
+	fillBlock(board, x0, y0, cisloTvaru, volba);
+	if (volba == 0 || (x0 == shownX && y0 == shownY && cisloTvaru == shownShape))
+		return;
+	if (shownShape >= 0)
+		markBlockDirty(shownX, shownY, shownShape);
+	markBlockDirty(x0, y0, cisloTvaru);
+	shownX = x0;
+	shownY = y0;
+	shownShape = cisloTvaru;
 }
 
 // Funkcia checkuje ci sa nenachadza objekt alebo ramec pred aktalnym objektom
-int checkBlockade(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	int temp = 0;
-	// ak objekt je stvorec
-	if (cisloTvaru == 0){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je |
-	else if (cisloTvaru == 1){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je stvorec _
-	else if (cisloTvaru == 2){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 + 1] == i || matrix[x0 + 18][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je Z
-	else if (cisloTvaru == 3){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 5] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je N
-	else if (cisloTvaru == 4){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 - 5] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny Z
-	else if (cisloTvaru == 5){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 - 5] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny N
-	else if (cisloTvaru == 6){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 5] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je L
-	else if (cisloTvaru == 7){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 8){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je '|
-	else if (cisloTvaru == 9){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 11] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je ,..
-	else if (cisloTvaru == 10){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 - 5] == i || matrix[x0 + 12][y0 - 5] == i)
-				temp = 1;
-	}
-	// ak objekt je .|.
-	else if (cisloTvaru == 11){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je -|
-	else if (cisloTvaru == 12){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 5] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je .,.
-	else if (cisloTvaru == 13){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 5] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 - 5] == i)
-				temp = 1;
-	}
-	// ak objekt je |-
-	else if (cisloTvaru == 14){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 - 5] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny L
-	else if (cisloTvaru == 15){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je ..,
-	else if (cisloTvaru == 16){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 - 5] == i || matrix[x0 + 6][y0 - 5] == i || matrix[x0 + 12][y0 + 1] == i)
-				temp = 1;
-	}
-	// ak objekt je |'
-	else if (cisloTvaru == 17){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 - 11] == i)
-				temp = 1;
-	}
-	// ak objekt je ._
-	else if (cisloTvaru == 18){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0][y0 + 1] == i || matrix[x0 + 6][y0 + 1] == i || matrix[x0 + 12][y0 + 1] == i)
-				temp = 1;
-	}
-	return temp;
+int checkBlockade(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	return !blockFits(x0, y0 + 1, cisloTvaru);
 }
 
-// Funkcia checkuje ci sa nenachadza objekt alemo ramec na lavej strane aktualneho objektu
-int checkLeftSide(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	int temp = 0;
-	// ak objekt je stvorec
-	if (cisloTvaru == 0){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |
-	else if (cisloTvaru == 1){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i || matrix[x0 - 1][y0 - 18] == i)
-				temp = 1;
-	}
-	// ak objekt je stvorec _
-	else if (cisloTvaru == 2){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i)
-				temp = 1;
-	}
-	// ak objekt je Z
-	else if (cisloTvaru == 3){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 5][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je N
-	else if (cisloTvaru == 4){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 + 5][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny Z
-	else if (cisloTvaru == 5){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 + 5][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny N
-	else if (cisloTvaru == 6){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 5][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je L
-	else if (cisloTvaru == 7){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 8){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 + 11][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je '|
-	else if (cisloTvaru == 9){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 5][y0] == i || matrix[x0 + 5][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ,..
-	else if (cisloTvaru == 10){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je .|.
-	else if (cisloTvaru == 11){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 + 5][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je -|
-	else if (cisloTvaru == 12){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 5][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 + 5][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je .,.
-	else if (cisloTvaru == 13){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 5][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |-
-	else if (cisloTvaru == 14){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny L
-	else if (cisloTvaru == 15){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 + 5][y0 - 6] == i || matrix[x0 + 5][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ..,
-	else if (cisloTvaru == 16){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 11][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |'
-	else if (cisloTvaru == 17){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i || matrix[x0 - 1][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ._
-	else if (cisloTvaru == 18){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 - 1][y0] == i || matrix[x0 - 1][y0 - 6] == i)
-				temp = 1;
-	}
-	return temp;
+// Funkcia vrati spodny riadok, na ktory objekt dopadne, ak pada rovno dole
+int dropRow(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	while (blockFits(x0, y0 + 1, cisloTvaru))
+		y0++;
+	return y0;
 }
 
-// Funkcia checkuje ci sa nenachadza objekt alemo ramec na pravej strane aktualneho objektu
-int checkRightSide(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	int temp = 0;
-	// ak objekt je stvorec
-	if (cisloTvaru == 0){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 12][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |
-	else if (cisloTvaru == 1){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 6][y0] == i || matrix[x0 + 6][y0 - 6] == i || matrix[x0 + 6][y0 - 12] == i || matrix[x0 + 6][y0 - 18] == i)
-				temp = 1;
-	}
-	// ak objekt je stvorec _
-	else if (cisloTvaru == 2){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i)
-				temp = 1;
-	}
-	// ak objekt je Z
-	else if (cisloTvaru == 3){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 18][y0] == i || matrix[x0 + 12][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je N
-	else if (cisloTvaru == 4){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 6][y0] == i || matrix[x0 + 12][y0 - 6] == i || matrix[x0 + 12][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny Z
-	else if (cisloTvaru == 5){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 18][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny N
-	else if (cisloTvaru == 6){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 12][y0-6] == i || matrix[x0 + 6][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je L
-	else if (cisloTvaru == 7){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 6][y0 - 6] == i || matrix[x0 + 6][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 8){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 18][y0] == i || matrix[x0 + 18][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je '|
-	else if (cisloTvaru == 9){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 12][y0 - 6] == i || matrix[x0 + 12][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ,..
-	else if (cisloTvaru == 10){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 6][y0] == i || matrix[x0 + 18][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je .|.
-	else if (cisloTvaru == 11){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 18][y0] == i || matrix[x0 + 12][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je -|
-	else if (cisloTvaru == 12){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 12][y0 - 6] == i || matrix[x0 + 12][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je .,.
-	else if (cisloTvaru == 13){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 18][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |-
-	else if (cisloTvaru == 14){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 6][y0] == i || matrix[x0 + 12][y0 - 6] == i || matrix[x0 + 6][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je opacny L
-	else if (cisloTvaru == 15){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 12][y0] == i || matrix[x0 + 12][y0 - 6] == i || matrix[x0 + 12][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ..,
-	else if (cisloTvaru == 16){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 18][y0] == i || matrix[x0 + 18][y0 - 6] == i)
-				temp = 1;
-	}
-	// ak objekt je |'
-	else if (cisloTvaru == 17){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 6][y0] == i || matrix[x0 + 6][y0 - 6] == i || matrix[x0 + 12][y0 - 12] == i)
-				temp = 1;
-	}
-	// ak objekt je ._
-	else if (cisloTvaru == 18){
-		for (int i = 2; i < 10; i++)
-			if (matrix[x0 + 18][y0] == i || matrix[x0 + 6][y0 - 6] == i)
-				temp = 1;
+// Funkcia checkuje ci sa nenachadza objekt alebo ramec na lavej strane objektu
+int checkLeftSide(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	return !blockFits(x0 - 1, y0, cisloTvaru);
+}
+
+// Funkcia checkuje ci sa nenachadza objekt alebo ramec na pravej strane objektu
+int checkRightSide(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	return !blockFits(x0 + 1, y0, cisloTvaru);
+}
+
+// Funkcia zbiera riadky, ktorych obsah sa po posune zmeni, a susedne zmenene riadky oznaci ako jeden obdlznik.
+// Riadky prichadzaju zdola nahor, riadok -1 ukonci posledny usek.
+static void markRowChanged(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int row, const uint8_t *next){
+	static int runBottom = -1, runTop = -1;
+
+	if (row >= 0 && memcmp(board[row], next, BOARD_STRIDE) != 0){
+		if (runBottom < 0)
+			runBottom = row;
+		runTop = row;
+		return;
 	}
-	return temp;
+	if (runBottom >= 0)
+		markDirty(BOARD_X, BOARD_Y + runTop * CELL_SIZE, BOARD_X + BOARD_COLS * CELL_SIZE - 1, BOARD_Y + (runBottom + 1) * CELL_SIZE - 1);
+	runBottom = -1;
 }
 
-// Funkcia checkuje ci sa nachadzaju naplnene riadky v matici a vymaze ich, a vrati bodovanie podla toho kolko riadkov boli vymazane
-int checkLineFilled(uint16_t matrix[128][128]){
-	int cRow[127];
+// Funkcia checkuje ci sa nachadzaju naplnene riadky na hracej ploche a vymaze ich, a vrati bodovanie podla toho kolko riadkov boli vymazane
+int checkLineFilled(uint8_t board[BOARD_ROWS][BOARD_STRIDE]){
+	static const uint8_t emptyRow[BOARD_STRIDE] = { 0 };
 	int temp = 0;
 	int count = 0;
-	int pom = 0;
-	for (int x = 0; x < 127; x++){
-		cRow[x] = 0;
-	}
-	for(int i = 0; i < 127; i++){
-		for(int j = 57;j < 117; j++){
-			for (int z = 2; z < 10; z++)
-				if (matrix[j][i] == z)
-					cRow[i] += 1;
-				}
-		if (cRow[i] == 60){
+	int top = 0;
+	int dst = BOARD_ROWS - 1;
+
+	if (fullRows == 0)
+		return 0;
+
+	// najvyssi obsadeny riadok, riadky nad nim sa posunom nezmenia
+	while (top < BOARD_ROWS && boardRows[top] == ROW_WALLS)
+		top++;
+
+	// jeden prechod zdola nahor, kazdy zostavajuci riadok sa presunie rovno na svoje miesto
+	for(int i = BOARD_ROWS - 1; i >= top; i--){
+		if (fullRows & (1UL << i)){
 			count++;
-			for(int j = 57; j < 117; j++){
-				matrix[j][i] = 0;
-			}
+			continue;
 		}
-	}
-	for(int i = 0; i < 127; i++){
-		for(int j = 57; j < 117; j++){
-			if (cRow[i] == 60){
-				pom = i;
-				while(pom != 0){
-					matrix[j][pom] = matrix[j][pom - 1];
-					pom--;
-				}
-			}
+		if (dst != i){
+			markRowChanged(board, dst, board[i]);
+			memcpy(board[dst], board[i], BOARD_STRIDE);
+			boardRows[dst] = boardRows[i];
 		}
+		dst--;
+	}
+	for(int i = dst; i >= top; i--){
+		markRowChanged(board, i, emptyRow);
+		memset(board[i], 0, BOARD_STRIDE);
+		boardRows[i] = ROW_WALLS;
 	}
-	if ((count / 6) == 1){
+	markRowChanged(board, -1, 0);
+	fullRows = 0;
+
+	if (count == 1){
 		temp = 100;
 	}
-	else if ((count / 6) == 2){
+	else if (count == 2){
 		temp = 200;
 	}
-	else if ((count / 6) == 3){
+	else if (count == 3){
 		temp = 300;
 	}
-	else if ((count / 6) == 4){
+	else if (count == 4){
 		temp = 800;
 	}
 	return temp;
 }
 
-// Funkcia checkuje ci sa objekt ktora nachadza uplne hore nema nieco pred sebou, ak ano tak hra sa skonci
-int checkGameOver(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	int temp = 0;
-	for (int i = 0; i < 19; i++)
-		for (int j = 2; j < 10; j++)
-			if ((cisloTvaru == i) && (y0 - 6)==0 && (matrix[x0][y0 + 1] == j))
-				temp = 1;
-	return temp;
+// Funkcia checkuje ci polozeny objekt nezostal ciastocne nad hracou plochou, ak ano tak hra sa skonci
+int checkGameOver(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	return y0 - blockShapes[cisloTvaru].h + 1 < 0;
 }
 
 // Funkcia vytvori ramec v ktorom sa uskutocnuje hra
-void createFrame(uint16_t matrix[128][128]){
-	for(int i = 56; i < 118; i++){
-		for(int j = 0;j < 128; j++){
-			if(i == 56)
-				matrix[i][j] = 2;
-			else if(i == 117)
-				matrix[i][j] = 2;
-			else if(j == 127)
-				matrix[i][j] = 2;
-			else
-				matrix[i][j] = 0;
+void createFrame(uint8_t board[BOARD_ROWS][BOARD_STRIDE]){
+	markDirty(BOARD_X - 1, 0, BOARD_X + BOARD_COLS * CELL_SIZE, 127);
+	memset(board, 0, BOARD_ROWS * BOARD_STRIDE);
+	for(int i = 0; i < BOARD_ROWS; i++)
+		boardRows[i] = ROW_WALLS;
+	fullRows = 0;
+	shownShape = -1;
+}
+
+// Hodnoty na lavej strane hry, ku kazdej sa pamata naposledy vypisany text
+#define HUD_LINES	0
+#define HUD_SCORE	1
+#define HUD_TIME	2
+#define HUD_PPM		3
+#define HUD_FIELDS	4
+#define HUD_WIDTH	8
+
+static const uint8_t hudRows[HUD_FIELDS] = { 5, 8, 11, 14 };
+static char hudText[HUD_FIELDS][HUD_WIDTH];
+
+// Funkcia vypise hodnotu na lavej strane, prekresli iba znaky, ktore sa od posledneho vypisu zmenili
+static void hudField(int field, const char *text){
+	int end = 0;
+	char c;
+
+	for (int i = 0; i < HUD_WIDTH; i++){
+		// za koncom textu sa uz necita, buffer moze byt kratsi ako HUD_WIDTH
+		if (!end && text[i] == '\0')
+			end = 1;
+		c = end ? ' ' : text[i];
+		if (c != hudText[field][i]){
+			lcdPutCh(c, lcdTextX(1 + i), lcdTextY(hudRows[field]), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+			hudText[field][i] = c;
 		}
 	}
 }
 
-// Funkcia vypise texty a lavej strane hry
+// Funkcia vypise texty a lavej strane hry, vola sa raz na zaciatku hry na vycistenej obrazovke
 void createText(char alias[7]){
+	memset(hudText, ' ', sizeof(hudText));
 	lcdPutS("Player:", lcdTextX(1), lcdTextY(1), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
 	for (int i = 0; i < 7; i++)
 		lcdPutCh(alias[i], lcdTextX(i + 1), lcdTextY(2), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
@@ -1017,563 +959,30 @@ void createText(char alias[7]){
 
 // Funkcia vykonava otocenie objektu
 int rotateObject(int cisloTvaru){
-	if (cisloTvaru == 1)
-		cisloTvaru += 1;
-	else if (cisloTvaru == 2)
-	  cisloTvaru -= 1;
-	else if (cisloTvaru == 3)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 4)
-	  cisloTvaru -= 1;
-	else if (cisloTvaru == 5)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 6)
-	  cisloTvaru -= 1;
-	else if (cisloTvaru == 7)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 8)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 9)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 10)
-	  cisloTvaru -= 3;
-	else if (cisloTvaru == 11)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 12)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 13)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 14)
-	  cisloTvaru -= 3;
-	else if (cisloTvaru == 15)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 16)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 17)
-	  cisloTvaru += 1;
-	else if (cisloTvaru == 18)
-	  cisloTvaru -= 3;
-	return cisloTvaru;
-}
-
-// Funkcia checkuje ci je mozne vykonat rotaciu, ci sa nechadaza objekt na pravej strane
-int checkRotation(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	int temp = 0;
-	if (cisloTvaru == 1){
-		for(int i = 0; i < 24; i++)
-			for(int j = 0; j < 6; j++)
-				for (int z = 2; z < 10; z++)
-					if (matrix[x0 + i][y0 - j] == z)
-						temp = 1;
-	}
-	else if (cisloTvaru == 2){
-		for(int i = 0; i < 6; i++)
-			for(int j = 0; j < 24; j++)
-				for (int z = 2; z < 10; z++)
-					if (matrix[x0 + i][y0 - j] == z)
-						temp = 1;
-	}
-	else if (cisloTvaru == 3){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j > 5 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && j < 12)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j < 12 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 4){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && i < 12)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 5){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j > 5 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && j < 12)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j < 12 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 6){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j > 5 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j < 6 && i < 12)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 7){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && i > 11)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 8){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 12 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 11)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 9){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 10){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j > 5 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 11){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if ((j > 5 && j < 12) && (i < 6))
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 12){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6 && (i > 5 && i < 12))
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 13){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if ((j > 5 && j < 12) && (i > 5))
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 14){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && (i > 5 && i < 12))
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 15){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6 && i > 11)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 16){
-		for(int i = 0;i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 12 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 11)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 17){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && i < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	else if (cisloTvaru == 18){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				for (int z = 2; z < 10; z++){
-					if (j < 6)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-					if (j > 5 && i > 5)
-						if (matrix[x0 + i][y0 - j] == z)
-							temp = 1;
-				}
-			}
-	}
-	return temp;
+	return blockShapes[cisloTvaru].next;
+}
+
+// Funkcia checkuje ci je mozne vykonat rotaciu, ci sa otoceny objekt zmesti na aktualne miesto
+int checkRotation(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	return !blockFits(x0, y0, rotateObject(cisloTvaru));
 }
 
 // Funkcia necha blok na tom mieste kde zastavil pred prekazkou, kazdy tvar inou farbou
-void placeDownBlock(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru){
-	// ak objekt je stvorec
-	if (cisloTvaru == 0){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 12; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = 3;
-	}
-	// ak objekt je obdlznik |
-	else if (cisloTvaru == 1){
-		for(int i = 0; i < 6; i++)
-			for(int j = 0; j < 24; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = 4;
-	}
-	// ak objekt je obdlznik _
-	else if (cisloTvaru == 2){
-		for(int i = 0; i < 24; i++)
-			for(int j = 0; j < 6; j++)
-				if (y0 - j > 1)
-					matrix[x0 + i][y0 - j] = 4;
-	}
-	// ak objekt je Z
-	else if (cisloTvaru == 3){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i > 5)
-						matrix[x0 + i][y0 - j] = 5;
-					if (j > 5 && i < 12)
-						matrix[x0 + i][y0 - j] = 5;
-				}
-			}
-	}
-	// ak objekt je N
-	else if (cisloTvaru == 4){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = 5;
-					if (j > 5 && j < 12)
-						matrix[x0 + i][y0 - j] = 5;
-					if (j < 12 && i < 6)
-						matrix[x0 + i][y0 - j] = 5;
-				}
-			}
-	}
-	// ak objekt je opan Z
-	else if (cisloTvaru == 5){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = 6;
-					if (j < 6 && i < 12)
-						matrix[x0 + i][y0 - j] = 6;
-				}
-			}
-	}
-	// ak objekt je opacny N
-	else if (cisloTvaru == 6){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = 6;
-					if (j > 5 && j < 12)
-						matrix[x0 + i][y0 - j] = 6;
-					if (j < 12 && i > 5)
-						matrix[x0 + i][y0 - j] = 6;
-				}
-			}
-	}
-	// ak objekt je L
-	else if (cisloTvaru == 7){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = 7;
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = 7;
-				}
-			}
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 8){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = 7;
-					if (j > 5 && i > 11)
-						matrix[x0 + i][y0 - j] = 7;
-				}
-			}
-	}
-	// ak objekt je '|
-	else if (cisloTvaru == 9){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 12 && i > 5)
-						matrix[x0 + i][y0 - j] = 7;
-					if (j > 11)
-						matrix[x0 + i][y0 - j] = 7;
-				}
-			}
-	}
-	// ak objekt je ,..
-	else if (cisloTvaru == 10){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i < 6)
-						matrix[x0 + i][y0 - j] = 7;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = 7;
-				}
-			}
-	}
-	// ak objekt je _._
-	else if (cisloTvaru == 11){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = 8;
-					if (j > 5 && (i > 5 && i < 12))
-						matrix[x0 + i][y0 - j] = 8;
-				}
-			}
-	}
-	// ak objekt je -|
-	else if (cisloTvaru == 12){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if ((j > 5 && j < 12) && (i < 6))
-						matrix[x0 + i][y0 - j] = 8;
-					if (i > 5)
-						matrix[x0 + i][y0 - j] = 8;
-				}
-			}
-	}
-	// ak objekt je ..,..
-	else if (cisloTvaru == 13){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && (i > 5 && i < 12))
-						matrix[x0 + i][y0 - j] = 8;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = 8;
-				}
-			}
-	}
-	// ak objekt je |-
-	else if (cisloTvaru == 14){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (i < 6)
-						matrix[x0 + i][y0 - j] = 8;
-					if ((j > 5 && j < 12) && (i > 5))
-						matrix[x0 + i][y0 - j] = 8;
-				}
-			}
-	}
-	// ak objekt je opacny L
-	else if (cisloTvaru == 15){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = 9;
-					if (j > 5 && i > 5)
-						matrix[x0 + i][y0 - j] = 9;
-				}
-			}
-	}
-	// ak objekt je ..,
-	else if (cisloTvaru == 16){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6 && i > 11)
-						matrix[x0 + i][y0 - j] = 9;
-					if (j > 5)
-						matrix[x0 + i][y0 - j] = 9;
-				}
-			}
-	}
-	// ak objekt je |'
-	else if (cisloTvaru == 17){
-		for(int i = 0; i < 12; i++)
-			for(int j = 0; j < 18; j++){
-				if (y0 - j > 1){
-					if (j < 12 && i < 6)
-						matrix[x0 + i][y0 - j] = 9;
-					if (j > 11)
-						matrix[x0 + i][y0 - j] = 9;
-				}
-			}
-	}
-	// ak objekt je _.
-	else if (cisloTvaru == 18){
-		for(int i = 0; i < 18; i++)
-			for(int j = 0; j < 12; j++){
-				if (y0 - j > 1){
-					if (j < 6)
-						matrix[x0 + i][y0 - j] = 9;
-					if (j > 5 && i < 6)
-						matrix[x0 + i][y0 - j] = 9;
-				}
-			}
-	}
+void placeDownBlock(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru){
+	markBlockDirty(x0, y0, cisloTvaru);
+	fillBlock(board, x0, y0, cisloTvaru, blockShapes[cisloTvaru].colour);
+	for(int j = 0; j < 4; j++)
+		if (y0 - j >= 0 && y0 - j < BOARD_ROWS){
+			boardRows[y0 - j] |= blockShapes[cisloTvaru].rows[j] << (x0 + 1);
+			if (boardRows[y0 - j] == ROW_FULL)
+				fullRows |= 1UL << (y0 - j);
+		}
 }
 
 // Funkcia vygeneruje nahdone cislo medzi 0 a 6, potom ak dane cislo ma viac tvarov, tak este vygeneruje nahodne cislo
-int generateNumber(volatile int AD_value){
-	int cislo = AD_value % 7;
-	int cisloTvaru = 0;
-	int temp = 0;
-
-	if (cislo == 0)
-		cisloTvaru = 0;
-	else if (cislo == 1){
-		temp = AD_value % 2;
-		if (temp == 0)
-			cisloTvaru = 1;
-		else if (temp == 1)
-			cisloTvaru = 2;
-	}
-	else if (cislo == 2){
-		temp = AD_value % 2;
-		if (temp == 0)
-			cisloTvaru = 3;
-		else if (temp == 1)
-			cisloTvaru = 4;
-	}
-	else if (cislo == 3){
-		temp = AD_value % 2;
-		if (temp == 0)
-			cisloTvaru = 5;
-		else if (temp == 1)
-			cisloTvaru = 6;
-	}
-	else if (cislo == 4){
-		temp = AD_value % 4;
-		if (temp == 0)
-			cisloTvaru = 7;
-		else if (temp == 1)
-			cisloTvaru = 8;
-		else if (temp == 2)
-			cisloTvaru = 9;
-		else if (temp == 3)
-			cisloTvaru = 10;
-	}
-	else if (cislo == 5){
-		temp = AD_value % 4;
-		if (temp == 0)
-			cisloTvaru = 11;
-		else if (temp == 1)
-			cisloTvaru = 12;
-		else if (temp == 2)
-			cisloTvaru = 13;
-		else if (temp == 3)
-			cisloTvaru = 14;
-	}
-	else if (cislo == 6){
-		temp = AD_value % 4;
-		if (temp == 0)
-			cisloTvaru = 15;
-		else if (temp == 1)
-			cisloTvaru = 16;
-		else if (temp == 2)
-			cisloTvaru = 17;
-		else if (temp == 3)
-			cisloTvaru = 18;
-	}
-	return cisloTvaru;
+int generateNumber(uint32_t seed){
+	const uint8_t *piece = blockPieces[seed % 7];
+	return piece[0] + seed % piece[1];
 }
 
 // Funkcia vrati pocet riadkov, ktore boli vymazane
@@ -1601,11 +1010,15 @@ int returnLines(int tempScore, int score){
 	return lines;
 }
 
-// Funkcia vykresli startovaciu obrazovku a riadi pohyb medzi volbami
-void drawMenu(volatile int AD_value, int volba){
+// Funkcia vykresli nadpis startovacej obrazovky
+void drawMenuTitle(void){
+	textPutS(".TETRIS.", 7, 2, TEXT_ATTR(TEXT_GREEN, TEXT_BLACK));
+	textPutS("THE STM32 GAME", 4, 4, TEXT_ATTR(TEXT_LIME, TEXT_BLACK));
+}
+
+// Funkcia vykresli volby startovacej obrazovky, zvolena volba je zvyraznena
+void drawMenu(int volba){
 	char* menuVolba[] = {"PLAY GAME", "CHANGE MY NAME", "HIGH SCORE"};
-	lcdPutS(".TETRIS.", lcdTextX(7), lcdTextY(2), decodeRgbValue(10, 31, 10), decodeRgbValue(0, 0, 0));
-	lcdPutS("THE STM32 GAME", lcdTextX(4), lcdTextY(4), decodeRgbValue(15, 31, 0), decodeRgbValue(0, 0, 0));
 	int x = 0;
 	int j = 1;
 
@@ -1617,21 +1030,21 @@ void drawMenu(volatile int AD_value, int volba){
 		else if (i == 2)
 			x = 6;
 		if(i == volba)
-			lcdPutS(menuVolba[i], lcdTextX(x), lcdTextY(i+7+j), decodeRgbValue(255, 255, 255), decodeRgbValue(31, 0, 0));
+			textPutS(menuVolba[i], x, i+7+j, TEXT_ATTR(TEXT_WHITE, TEXT_RED));
 		else
-			lcdPutS(menuVolba[i], lcdTextX(x), lcdTextY(i+7+j), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
+			textPutS(menuVolba[i], x, i+7+j, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
 		j++;
 	}
 }
 
 // Funkcia vrati hodnotu vybranej volby
-int returnVolba(volatile int AD_value, int volba){
-	if ((AD_value > 1700) && (AD_value < 2300)){
+int returnVolba(int key, int volba){
+	if (key == INPUT_LEFT){
 		volba += 1;
 		if (volba > 2)
 			volba = 0;
 	}
-	else if ((AD_value > 2500) && (AD_value < 3100)){
+	else if (key == INPUT_RIGHT){
 		volba -= 1;
 		if (volba < 0)
 			volba = 2;
@@ -1640,17 +1053,15 @@ int returnVolba(volatile int AD_value, int volba){
 }
 
 // Funkcia vrati hodnotu dalsieho vybraneho okna
-int returnRun(volatile int AD_value, int volba, int run){
-	if (((AD_value > 3300) && (AD_value < 3650)) && volba == 0){
-		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+int returnRun(int key, int volba, int run){
+	int select = (key == INPUT_DOWN || key == INPUT_ROTATE);
+	if (select && volba == 0){
 		run = 1;
 	}
-	else if (((AD_value > 3300) && (AD_value < 3650)) && volba == 1){
-		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	else if (select && volba == 1){
 		run = 2;
 	}
-	else if (((AD_value > 3300) && (AD_value < 3650)) && volba == 2){
-		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	else if (select && volba == 2){
 		run = 3;
 	}
 	return run;
@@ -1662,44 +1073,47 @@ void showHighscore(int highscore[], char* names[]){
 	int j = 5;
 
 	for (int i = 0; i < 7; i++){
-		lcdPutCh(names[0][i], lcdTextX(i + 6), lcdTextY(5), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-		lcdPutCh(names[1][i], lcdTextX(i + 6), lcdTextY(7), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-		lcdPutCh(names[2][i], lcdTextX(i + 6), lcdTextY(9), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-		lcdPutCh(names[3][i], lcdTextX(i + 6), lcdTextY(11), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-		lcdPutCh(names[4][i], lcdTextX(i + 6), lcdTextY(13), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
+		textPutCh(names[0][i], i + 6, 5, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+		textPutCh(names[1][i], i + 6, 7, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+		textPutCh(names[2][i], i + 6, 9, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+		textPutCh(names[3][i], i + 6, 11, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+		textPutCh(names[4][i], i + 6, 13, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
 		if (i < 5){
-			sprintf(hScore, "%d", highscore[i]);
-			lcdPutS(hScore, lcdTextX(15), lcdTextY(j), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-			lcdPutS(":", lcdTextX(14), lcdTextY(j), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+			formatStatsUint(hScore, sizeof(hScore), highscore[i]);
+			textPutS(hScore, 15, j, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+			textPutS(":", 14, j, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
 			j = j + 2;
 		}
 	}
-	lcdPutS("HIGHSCORE", lcdTextX(6), lcdTextY(2), decodeRgbValue(10, 31, 10), decodeRgbValue(0, 0, 0));
-	lcdPutS("1.", lcdTextX(3), lcdTextY(5), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("2.", lcdTextX(3), lcdTextY(7), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("3.", lcdTextX(3), lcdTextY(9), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("4.", lcdTextX(3), lcdTextY(11), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("5.", lcdTextX(3), lcdTextY(13), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("BACK", lcdTextX(1), lcdTextY(15), decodeRgbValue(255, 255, 255), decodeRgbValue(31, 0, 0));
+	textPutS("HIGHSCORE", 6, 2, TEXT_ATTR(TEXT_GREEN, TEXT_BLACK));
+	textPutS("1.", 3, 5, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("2.", 3, 7, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("3.", 3, 9, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("4.", 3, 11, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("5.", 3, 13, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("BACK", 1, 15, TEXT_ATTR(TEXT_WHITE, TEXT_RED));
 }
 
 // Funkcia prepne hodnotu run na 0 ak je stlacene hociktore tlacidlo
-int goBack(volatile int AD_value, int run){
-	if ((AD_value > 1700) && (AD_value < 3650)){
-		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+int goBack(int key, int run){
+	if (key != INPUT_NONE){
 		run = 0;
 	}
 	return run;
 }
 
+// Funkcia vypise aktualne meno hraca
+void drawOldName(char alias[7]){
+	textPutS("OLD NAME:", 3, 1, TEXT_ATTR(TEXT_GREEN, TEXT_BLACK));
+	for (int i = 0; i < 7; i++)
+		textPutCh(alias[i], 13 + i, 1, TEXT_ATTR(TEXT_YELLOW, TEXT_BLACK));
+}
+
 // Funkcia vypise na obrazovku ABC a umoznuje prepnut medzi nimi
-void drawABC(int abcVolba, char alias[7]){
+void drawABC(int abcVolba){
 	char* abc[] = {"A","B","C","D","E","F","G","H","I","J","K","L","M","N","O","P","Q","R","S","T","U","V","W","X","Y","Z","Esc","Del","Ent"};
 	int k = 2;
 	int y = 4;
-	lcdPutS("OLD NAME:", lcdTextX(3), lcdTextY(1), decodeRgbValue(10, 31, 10), decodeRgbValue(0, 0, 0));
-	for (int i = 0; i < 7; i++)
-		lcdPutCh(alias[i], lcdTextX(13 + i), lcdTextY(1), decodeRgbValue(31, 31, 0), decodeRgbValue(0, 0, 0));
 	for(int i = 0; i < 29; i++){
 		if (k < 17 && y < 10){
 			k = k + 2;
@@ -1713,25 +1127,25 @@ void drawABC(int abcVolba, char alias[7]){
 		}
 		if (i == abcVolba)
 			if (y > 9)
-				lcdPutS(abc[i], lcdTextX(k), lcdTextY(y), decodeRgbValue(31, 0, 0), decodeRgbValue(10, 31, 10));
+				textPutS(abc[i], k, y, TEXT_ATTR(TEXT_RED, TEXT_GREEN));
 			else
-				lcdPutS(abc[i], lcdTextX(k), lcdTextY(y), decodeRgbValue(255, 255, 255), decodeRgbValue(31, 0, 0));
+				textPutS(abc[i], k, y, TEXT_ATTR(TEXT_WHITE, TEXT_RED));
 		else
 			if (y > 9)
-				lcdPutS(abc[i], lcdTextX(k), lcdTextY(y), decodeRgbValue(10, 31, 10), decodeRgbValue(0, 0, 0));
+				textPutS(abc[i], k, y, TEXT_ATTR(TEXT_GREEN, TEXT_BLACK));
 			else
-				lcdPutS(abc[i], lcdTextX(k), lcdTextY(y), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
+				textPutS(abc[i], k, y, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
 	}
 }
 
 // Funkcia vrati hodnotu ABC volby
-int returnAbcVolba(volatile int AD_value, int abcVolba){
-	if ((AD_value > 1700) && (AD_value < 2300)){
+int returnAbcVolba(int key, int abcVolba){
+	if (key == INPUT_LEFT){
 		abcVolba += 1;
 		if (abcVolba > 28)
 			abcVolba = 0;
 	}
-	else if ((AD_value > 2500) && (AD_value < 3100)){
+	else if (key == INPUT_RIGHT){
 		abcVolba -= 1;
 		if (abcVolba < 0)
 			abcVolba = 28;
@@ -1740,27 +1154,26 @@ int returnAbcVolba(volatile int AD_value, int abcVolba){
 }
 
 // Funkcia vymeni meno hraca alebo vrati naspat do menu
-void changeName(volatile int AD_value, int abcVolba, int *index, char newAlias[7], int *run, char alias[7]){
+void changeName(int key, int abcVolba, int *index, char newAlias[7], int *run, char alias[7]){
 	char abc[] = {'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P','Q','R','S','T','U','V','W','X','Y','Z'};
-	if ((AD_value > 3300) && (AD_value < 3650)){
+	if (key == INPUT_DOWN || key == INPUT_ROTATE){
 		if (abcVolba < 26 && *index < 7){
 			newAlias[*index] = abc[abcVolba];
-			lcdPutCh(newAlias[*index], lcdTextX(*index + 7), lcdTextY(12), decodeRgbValue(31, 31, 0), decodeRgbValue(0, 0, 0));
+			textPutCh(newAlias[*index], *index + 7, 12, TEXT_ATTR(TEXT_YELLOW, TEXT_BLACK));
 			*index = *index + 1;
 		}
 		else if (abcVolba < 26 && *index > 6){
-			lcdPutS("MAX 7 CHARS!!!", lcdTextX(4), lcdTextY(14), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+			textPutS("MAX 7 CHARS!!!", 4, 14, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
 		}
 		else if (abcVolba == 26){
 			*index = 0;
-			lcdClearDisplay(decodeRgbValue(0, 0, 0));
 			*run = 0;
 		}
 		else if (abcVolba == 27 && *index > 0){
 			*index = *index - 1;
 			newAlias[*index] = ' ';
-			lcdPutCh(newAlias[*index], lcdTextX(*index + 7), lcdTextY(12), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-			lcdPutS("MAX 7 CHARS!!!", lcdTextX(4), lcdTextY(14), decodeRgbValue(0, 0, 0), decodeRgbValue(0, 0, 0));
+			textPutCh(newAlias[*index], *index + 7, 12, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+			textPutS("MAX 7 CHARS!!!", 4, 14, TEXT_ATTR(TEXT_BLACK, TEXT_BLACK));
 		}
 		else if (abcVolba == 28 && (newAlias[0] != '\0' && newAlias[0] != ' ')){
 			for (int i = 0; i < 7; i++){
@@ -1768,7 +1181,6 @@ void changeName(volatile int AD_value, int abcVolba, int *index, char newAlias[7
 				alias[i] = newAlias[i];
 				newAlias[i] = ' ';
 			}
-			lcdClearDisplay(decodeRgbValue(0, 0, 0));
 			*index = 0;
 			*run = 0;
 		}
@@ -1797,221 +1209,110 @@ void drawGameOver(char scoree[7], int score, int highscore[], char* names[], cha
 		highscore[4] = score;
 		names[4] = alias;
 	}
-	lcdPutS("Game Over!", lcdTextX(6), lcdTextY(2), decodeRgbValue(10, 31, 10), decodeRgbValue(0, 0, 0));
-	lcdPutS("Chin up", lcdTextX(4), lcdTextY(6), decodeRgbValue(31, 31, 31), decodeRgbValue(0, 0, 0));
-	lcdPutS(alias, lcdTextX(12), lcdTextY(6), decodeRgbValue(31, 31, 0), decodeRgbValue(0, 0, 0));
-	lcdPutS("Score :", lcdTextX(4), lcdTextY(8), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-	lcdPutS(scoree, lcdTextX(12), lcdTextY(8), decodeRgbValue(31, 31, 31), decodeRgbValue(0, 0, 0));
-	lcdPutS("Time  :", lcdTextX(4), lcdTextY(10), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
-	lcdPutS(time, lcdTextX(12), lcdTextY(10), decodeRgbValue(31, 31, 31), decodeRgbValue(0, 0, 0));
-	lcdPutS("P/min :", lcdTextX(4), lcdTextY(12), decodeRgbValue(31, 0, 0), decodeRgbValue(0, 0, 0));
+	textPutS("Game Over!", 6, 2, TEXT_ATTR(TEXT_GREEN, TEXT_BLACK));
+	textPutS("Chin up", 4, 6, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS(alias, 12, 6, TEXT_ATTR(TEXT_YELLOW, TEXT_BLACK));
+	textPutS("Score :", 4, 8, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+	textPutS(scoree, 12, 8, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("Time  :", 4, 10, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
+	textPutS(time, 12, 10, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("P/min :", 4, 12, TEXT_ATTR(TEXT_RED, TEXT_BLACK));
 	for (int i = 0; i < 8; i++)
-		lcdPutCh(pm[i], lcdTextX(12 + i), lcdTextY(12), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-	lcdPutS("BACK", lcdTextX(1), lcdTextY(15), decodeRgbValue(255, 255, 255), decodeRgbValue(31, 0, 0));
+		textPutCh(pm[i], 12 + i, 12, TEXT_ATTR(TEXT_WHITE, TEXT_BLACK));
+	textPutS("BACK", 1, 15, TEXT_ATTR(TEXT_WHITE, TEXT_RED));
 }
 
 // Funkcia resetuje parametre pre novu hru
-void clearData(volatile int AD_value, int *score, float *time, int *odstRiad, float *ppm, int *run, uint8_t blockX[1000], uint8_t blockY[1000], uint8_t xDir[1000], uint8_t yDir[1000], int *count, uint16_t matrix[128][128], char ppmStr[8]){
-	if ((AD_value > 1700) && (AD_value < 3650)){
-		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+void clearData(int key, int *score, int *time, int *odstRiad, int *ppm, int *run, uint8_t blockX[1000], int8_t blockY[1000], uint8_t xDir[1000], uint8_t yDir[1000], int *count, uint8_t board[BOARD_ROWS][BOARD_STRIDE], char ppmStr[8]){
+	if (key != INPUT_NONE){
 		*score = 0;
 		*time = 0;
 		*odstRiad = 0;
 		*ppm = 0;
-		for (int i = 0; i < 8; i++)
-			if (i == 0)
-				ppmStr[i] = '0';
-			else
-				ppmStr[i] = ' ';
+		formatStatsTenths(ppmStr, 8, 0);
 		*run = 0;
 		for (int i = 0; i < 1000; i++){
-			blockX[i] = 81; blockY[i] = 0; xDir[i] = 6; yDir[i] = 6;
+			blockX[i] = BLOCK_START_X; blockY[i] = BLOCK_START_Y; xDir[i] = 1; yDir[i] = 1;
 		}
 		*count = 0;
-		createFrame(matrix);
+		createFrame(board);
 	}
 }
 
-// Funkcia riadi jednotlive klavesy
-void buttonPressed(volatile int AD_value, uint8_t *xDir, uint16_t matrix[128][128], uint8_t *blockX, uint8_t *blockY, int *cisloTvaru, int *rotCheck){
+// Funkcia riadi posun a rotaciu, tlacidlo dole riadi gravitacia hry (soft a hard drop)
+void buttonPressed(int key, uint8_t *xDir, uint8_t board[BOARD_ROWS][BOARD_STRIDE], uint8_t *blockX, int8_t *blockY, int *cisloTvaru, int *rotCheck){
 	// ked gombiky su stlacene, tak posuva objekt dolava alebo doprava
-	if ((AD_value > 1700) && (AD_value < 2300)){
-		*xDir = 6;
+	if (key == INPUT_LEFT){
+		*xDir = 1;
 		// v kazdom kroku checkuje ci sa nenachadza nieco na lavej strane objektu
-		if (checkLeftSide(matrix, *blockX, *blockY, *cisloTvaru))
+		if (checkLeftSide(board, *blockX, *blockY, *cisloTvaru))
 		  *xDir = 0;
 		else
 		  *blockX -= *xDir; // dolava
 	}
-	else if ((AD_value > 2500) && (AD_value < 3100)){
-		*xDir = 6;
+	else if (key == INPUT_RIGHT){
+		*xDir = 1;
 		// v kazdom kroku checkuje ci sa nenachadza nieco na pravej strane objektu
-		if (checkRightSide(matrix, *blockX, *blockY, *cisloTvaru))
+		if (checkRightSide(board, *blockX, *blockY, *cisloTvaru))
 			*xDir = 0;
 		else
 			*blockX += *xDir; // doprava
 	}
 	// ak stlacime stvrte tlacidlo, otoci sa objekt
-	else if ((AD_value > 3520) && (AD_value < 3650) && *rotCheck == 0){
-		if (!checkRotation(matrix, *blockX, *blockY, *cisloTvaru)){
+	else if (key == INPUT_ROTATE && *rotCheck == 0){
+		if (!checkRotation(board, *blockX, *blockY, *cisloTvaru)){
 			*cisloTvaru = rotateObject(*cisloTvaru);
 			*rotCheck=1;
 		}
 	}
-	// ak stlacime tretie tlacidlo, tak posunutie dole je zrychlene
-	else if ((AD_value > 3300) && (AD_value < 3450)){
-		if (checkBlockade(matrix, *blockX, *blockY+12, *cisloTvaru))
-			*blockY += 0;
-		else
-			*blockY += 6;
-	}
 }
 
 // Funkcia checkuje ci sa nenachadza objekt pred danym tvarom a checkuje ci sa nenastane koniec hry
-void checkObstacleAndGameOver(uint16_t matrix[128][128], uint8_t *blockX, uint8_t *blockY, int *cisloTvaru, uint8_t *yDir, int *run, int *cisObj, volatile int AD_value){
+void checkObstacleAndGameOver(uint8_t board[BOARD_ROWS][BOARD_STRIDE], uint8_t *blockX, int8_t *blockY, int *cisloTvaru, uint8_t *yDir, int *run, int *cisObj, uint32_t seed){
 	// v kazdom kroku checkuje, ci sa nenachadza dalsi objekt alebo ramec pred objektom
-	if (checkBlockade(matrix, *blockX, *blockY, *cisloTvaru))
+	if (checkBlockade(board, *blockX, *blockY, *cisloTvaru))
 	{
 	  // zastavi sa objekt
 	  *yDir = 0;
 	  // necha objekt na konecnom mieste
-	  placeDownBlock(matrix, *blockX, *blockY, *cisloTvaru);
+	  placeDownBlock(board, *blockX, *blockY, *cisloTvaru);
 	  // GAME OVER
-	  if(checkGameOver(matrix, *blockX, *blockY, *cisloTvaru)){
-		  matrixPlot(matrix, *cisloTvaru);
-		  lcdClearDisplay(decodeRgbValue(0, 0, 0));
+	  if(checkGameOver(board, *blockX, *blockY, *cisloTvaru))
 		  *run = 4;
-	  }
 	  // vygenerujeme dalsi objekt
 	  *cisObj = *cisObj + 1;
 	  if (*cisObj > 999)
 		  *run = 4;
-	  *cisloTvaru = generateNumber(AD_value);
+	  *cisloTvaru = generateNumber(seed);
 	}
 }
 
 // Funkcia aktualizuje hodnoty textov na lavej strane pocas hry
-void updateText( int *score, uint16_t matrix[128][128], int *odstRiad, char scoreStr[7], char odstRiadStr[7], float *time, char timeStr[7], float *ppm, char ppmStr[8], int gTimeStamp){
-	int tempScore = 0, timeInt = 0;
+void updateText( int *score, uint8_t board[BOARD_ROWS][BOARD_STRIDE], int *odstRiad, char scoreStr[7], char odstRiadStr[7], int *time, char timeStr[7], int *ppm, char ppmStr[8], int gTimeStamp){
+	int tempScore = 0;
 
 	// checkuje naplnene riadky
 	tempScore = *score;
-	*score += checkLineFilled(matrix);
+	*score += checkLineFilled(board);
 	*odstRiad += returnLines(tempScore, *score);
 
 	// Vypise score
-	sprintf(scoreStr, "%d", *score);
-	lcdPutS(scoreStr, lcdTextX(1), lcdTextY(8), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+	formatStatsUint(scoreStr, 7, *score);
+	hudField(HUD_SCORE, scoreStr);
 
 	// Vypise odstranene riadky
-	sprintf(odstRiadStr, "%d", *odstRiad);
-	lcdPutS(odstRiadStr, lcdTextX(1), lcdTextY(5), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+	formatStatsUint(odstRiadStr, 7, *odstRiad);
+	hudField(HUD_LINES, odstRiadStr);
 
 	// Vypise cas
 	*time = gTimeStamp;
-	timeInt = *time;
-	sprintf(timeStr, "%d", timeInt);
-	lcdPutS(timeStr, lcdTextX(1), lcdTextY(11), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
+	formatStatsUint(timeStr, 7, *time);
+	hudField(HUD_TIME, timeStr);
 
-	// Vypise score/min
-	*ppm = *score/(*time/60);
-	convertFloatToChar(*ppm, ppmStr);
-	for (int i = 0; i < 8; i++)
-		lcdPutCh(ppmStr[i], lcdTextX(1 + i), lcdTextY(14), decodeRgbValue(255, 255, 255), decodeRgbValue(0, 0, 0));
-}
-
-// Funkcia na konvertovanie float hodnoty na integer
-void convertFloatToChar(float cis, char text[8]){
-	int c1, c2, c3, c4, c5, d, temp, number = cis;
-	if (number < 1){
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = '0';
-		text[1] = '.';
-		text[2] = d + '0';
-		text[3] = ' ';
-		text[4] = ' ';
-		text[5] = ' ';
-		text[6] = ' ';
-		text[7] = ' ';
-	}
-	else if (number >= 1 && number < 10){
-		c1 = cis;
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = c1 + '0';
-		text[1] = '.';
-		text[2] = d + '0';
-		text[3] = ' ';
-		text[4] = ' ';
-		text[5] = ' ';
-		text[6] = ' ';
-		text[7] = ' ';
-	}
-	else if (number >= 10 && number < 100){
-		c1 = cis/10;
-		c2 = cis-(10*c1);
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = c1 + '0';
-		text[1] = c2 + '0';
-		text[2] = '.';
-		text[3] = d + '0';
-		text[4] = ' ';
-		text[5] = ' ';
-		text[6] = ' ';
-		text[7] = ' ';
-	}
-	else if (number >= 100 && number < 1000){
-		c1 = cis/100;
-		c2 = (cis-(100*c1))/10;
-		c3 = cis-(100*c1 + c2*10);
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = c1 + '0';
-		text[1] = c2 + '0';
-		text[2] = c3 + '0';
-		text[3] = '.';
-		text[4] = d + '0';
-		text[5] = ' ';
-		text[6] = ' ';
-		text[7] = ' ';
-	}
-	else if (number >= 1000 && number < 10000){
-		c1 = cis/1000;
-		c2 = (cis-(1000*c1))/100;
-		c3 = (cis-(1000*c1 + c2*100))/10;
-		c4 = (cis-(1000*c1 + c2*100 + c3*10));
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = c1 + '0';
-		text[1] = c2 + '0';
-		text[2] = c3 + '0';
-		text[3] = c4 + '0';
-		text[4] = '.';
-		text[5] = d + '0';
-		text[6] = ' ';
-		text[7] = ' ';
-	}
-	else if  (number >= 10000 && number < 100000){
-		c1 = cis/10000;
-		c2 = (cis-(10000*c1))/1000;
-		c3 = (cis-(10000*c1 + c2*1000))/100;
-		c4 = (cis-(10000*c1 + c2*1000 + c3*100))/10;
-		c5 = (cis-(10000*c1 + c2*1000 + c3*100 + c4*10));
-		temp = cis;
-		d = (cis * 10) - (temp * 10);
-		text[0] = c1 + '0';
-		text[1] = c2 + '0';
-		text[2] = c3 + '0';
-		text[3] = c4 + '0';
-		text[4] = c5 + '0';
-		text[5] = '.';
-		text[6] = d + '0';
-		text[7] = ' ';
-	}
-	else if  (number >= 100000)
-		text = "99999.9";
+	// Vypise score/min, v desatinach bez float aritmetiky
+	*ppm = statsPerMinuteTenths(*score, *time);
+	formatStatsTenths(ppmStr, 8, *ppm);
+	hudField(HUD_PPM, ppmStr);
 }
 
 // Funkcia ktor inicializuje daje pre asova
@@ -119,11 +119,37 @@
 #define NEGATIVE_GAMMA_CORRECT	0xE1
 #define GAM_R_SEL				0xF2
 
+// SET_PIXEL_FORMAT parameters, 12 bits per pixel sends two pixels in three bytes
+#define PIXEL_FORMAT_12BIT		0x03
+#define PIXEL_FORMAT_16BIT		0x05
+
+// Pixel format set by lcdInitialise(), lcdSetPixelFormat() changes it at run time
+#ifndef LCD_PIXEL_FORMAT
+#define LCD_PIXEL_FORMAT		PIXEL_FORMAT_16BIT
+#endif
+
+// Hracia plocha: 10x21 buniek po 6x6 pixelov, bunka [0][0] je v lavom hornom rohu
+// a ma lavy horny pixel na BOARD_X, BOARD_Y. Ramec je o jeden pixel okolo plochy.
+// Hodnota bunky (4 bity, dve bunky v bajte): 0 prazdna, 1 aktualny objekt, 3-9 polozene objekty podla farby
+#define BOARD_COLS		10
+#define BOARD_STRIDE	(BOARD_COLS / 2)
+#define BOARD_ROWS		21
+#define CELL_SIZE		6
+#define BOARD_X			57
+#define BOARD_Y			1
+
+// Startovacia pozicia objektu (stlpec a spodny riadok, objekt zacina nad plochou)
+#define BLOCK_START_X	4
+#define BLOCK_START_Y	-1
+
 // Macros and in-lines:
 
 // Translates a 3 byte RGB value into a 2 byte value for the LCD (values should be 0-31)
 uint16_t decodeRgbValue(uint8_t r, uint8_t g, uint8_t b);
 
+// The same as decodeRgbValue() for constant tables
+#define RGB_VALUE(r, g, b)	(((b) << 11) | ((g) << 6) | (r))
+
 // This routine takes a row number from 0 to 20 and
 // returns the x coordinate on the screen (0-127) to make
 // it easy to place text
@@ -145,48 +171,74 @@ void lcdWriteCommand(uint8_t address);
 void lcdWriteParameter(uint8_t parameter);
 void lcdWriteData(uint8_t dataByte1, uint8_t dataByte2);
 void lcdInitialise(uint8_t orientation);
+void lcdSetWindow(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+void lcdWriteRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, const uint16_t *pixels);
+void lcdFillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t colour);
+void lcdSetPixelFormat(uint8_t format);
+uint32_t lcdPixelBytes(void);
+
+// Character cell text buffer, TEXT_ATTR() packs the fg and bg colour index
+#define TEXT_COLS		21
+#define TEXT_ROWS		16
+#define TEXT_BLACK		0
+#define TEXT_WHITE		1
+#define TEXT_RED		2
+#define TEXT_GREEN		3
+#define TEXT_LIME		4
+#define TEXT_YELLOW		5
+#define TEXT_COLOURS	6
+#define TEXT_ATTR(fg, bg)	((fg) | ((bg) << 4))
+
+void textClear(void);
+void textPutCh(char character, uint8_t column, uint8_t row, uint8_t attr);
+void textPutS(const char *string, uint8_t column, uint8_t row, uint8_t attr);
+void textFlush(void);
 
 // Funkcie potrebne na pracu s displayom
 void lcdClearDisplay(uint16_t colour);
-void matrixPlot(uint16_t matrix[128][128], int cisloTvaru);
+void matrixPlot(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int cisloTvaru);
+void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
 void lcdPutCh(unsigned char character, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour);
+void lcdGlyphStats(uint32_t *hits, uint32_t *misses);
 void lcdPutS(const char *string, uint8_t x, uint8_t y, uint16_t fgColour, uint16_t bgColour);
 void createText(char alias[7]);
-void createFrame(uint16_t matrix[128][128]);
-void convertFloatToChar(float number, char text[8]);
+void createFrame(uint8_t board[BOARD_ROWS][BOARD_STRIDE]);
 
 // funkcie hlavneho okna
-void drawMenu(volatile int AD_value, int volba);
-int returnVolba(volatile int AD_value, int volba);
-int returnRun(volatile int AD_value, int volba, int run);
+void drawMenuTitle(void);
+void drawMenu(int volba);
+int returnVolba(int key, int volba);
+int returnRun(int key, int volba, int run);
 
 // funkcie okna high score
 void showHighscore(int highscore[], char* names[]);
-int goBack(volatile int AD_value, int run);
+int goBack(int key, int run);
 
 // funkcie okna change my name
-void drawABC(int abcVolba, char alias[7]);
-int returnAbcVolba(volatile int AD_value, int abcVolba);
-void changeName(volatile int AD_value, int abcVolba, int *index, char newAlias[7], int *run, char alias[7]);
+void drawOldName(char alias[7]);
+void drawABC(int abcVolba);
+int returnAbcVolba(int key, int abcVolba);
+void changeName(int key, int abcVolba, int *index, char newAlias[7], int *run, char alias[7]);
 
 // funkcie okna game over
 void drawGameOver(char scoree[7], int score, int highscore[], char* names[], char alias[7], char time[7], char pm[7]);
-void clearData(volatile int AD_value, int *score, float *time, int *odstRiad, float *ppm, int *run, uint8_t blockX[1000], uint8_t blockY[1000], uint8_t xDir[1000], uint8_t yDir[1000], int *count, uint16_t matrix[128][128], char ppmStr[8]);
+void clearData(int key, int *score, int *time, int *odstRiad, int *ppm, int *run, uint8_t blockX[1000], int8_t blockY[1000], uint8_t xDir[1000], uint8_t yDir[1000], int *count, uint8_t board[BOARD_ROWS][BOARD_STRIDE], char ppmStr[8]);
 
 // funkcie pre Tetris
-void buttonPressed(volatile int AD_value, uint8_t *xDir, uint16_t matrix[128][128], uint8_t *blockX, uint8_t *blockY, int *cisloTvaru, int *rotCheck);
-void checkObstacleAndGameOver(uint16_t matrix[128][128], uint8_t *blockX, uint8_t *blockY, int *cisloTvaru, uint8_t *yDir, int *run, int *cisObj, volatile int AD_value);
-void updateText( int *score, uint16_t matrix[128][128], int *odstRiad, char scoreStr[7], char odstRiadStr[7], float *time, char timeStr[7], float *ppm, char ppmStr[7], int gTimeStamp);
-void createDeleteBlock(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru, int volba);
-void placeDownBlock(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
+void buttonPressed(int key, uint8_t *xDir, uint8_t board[BOARD_ROWS][BOARD_STRIDE], uint8_t *blockX, int8_t *blockY, int *cisloTvaru, int *rotCheck);
+void checkObstacleAndGameOver(uint8_t board[BOARD_ROWS][BOARD_STRIDE], uint8_t *blockX, int8_t *blockY, int *cisloTvaru, uint8_t *yDir, int *run, int *cisObj, uint32_t seed);
+void updateText( int *score, uint8_t board[BOARD_ROWS][BOARD_STRIDE], int *odstRiad, char scoreStr[7], char odstRiadStr[7], int *time, char timeStr[7], int *ppm, char ppmStr[7], int gTimeStamp);
+void createDeleteBlock(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru, int volba);
+void placeDownBlock(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
 int rotateObject(int cisloTvaru);
-int checkBlockade(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
-int checkLineFilled(uint16_t matrix[128][128]);
-int checkLeftSide(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
-int checkRightSide(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
-int checkRotation(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
-int generateNumber(volatile int AD_value);
-int checkGameOver(uint16_t matrix[128][128], int16_t x0, int16_t y0, int cisloTvaru);
+int checkBlockade(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
+int dropRow(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
+int checkLineFilled(uint8_t board[BOARD_ROWS][BOARD_STRIDE]);
+int checkLeftSide(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
+int checkRightSide(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
+int checkRotation(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
+int generateNumber(uint32_t seed);
+int checkGameOver(uint8_t board[BOARD_ROWS][BOARD_STRIDE], int16_t x0, int16_t y0, int cisloTvaru);
 int returnLines(int tempScore, int score);
 
 #endif /* ILI9163LCD_H_ */
@@ -0,0 +1,147 @@
+/*
+ * input.c
+ *
+ * Keypad input, see input.h. inputTick() runs in the SysTick interrupt
+ * and is the only producer of the event queue, the main loop is the only
+ * consumer, so the queue needs no locking.
+ */
+
+#include "input.h"
+#include "events.h"
+#include "stm32l1xx.h"
+
+// A held key stays pressed while the value is within its band widened by
+// INPUT_HYSTERESIS, a new key needs INPUT_DEBOUNCE equal samples
+#define INPUT_HYSTERESIS	30
+#define INPUT_DEBOUNCE		5
+#define INPUT_QUEUE_LEN		16
+
+typedef struct {
+	int16_t low, high;
+} KeyBand;
+
+// ADC values of the keys, INPUT_NONE is everything outside the bands
+static const KeyBand keyBands[INPUT_KEYS] = {
+	{ 0, 0 },
+	{ 1700, 2300 },		// INPUT_LEFT
+	{ 2500, 3100 },		// INPUT_RIGHT
+	{ 3300, 3450 },		// INPUT_DOWN
+	{ 3520, 3650 },		// INPUT_ROTATE
+};
+
+volatile uint16_t gAdcSamples[INPUT_ADC_SAMPLES];
+
+static InputEvent queue[INPUT_QUEUE_LEN];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+
+static volatile uint8_t heldKey = INPUT_NONE;
+static uint8_t candidateKey = INPUT_NONE;
+static uint8_t candidateCount = 0;
+
+// Median of count samples (the upper one for an even count). The DMA keeps
+// writing, so the samples are copied first and sorted by insertion.
+int inputMedian(const volatile uint16_t *samples, uint8_t count)
+{
+	uint16_t sorted[INPUT_ADC_SAMPLES];
+	uint16_t value;
+	uint8_t i, j;
+
+	if (count > INPUT_ADC_SAMPLES)
+		count = INPUT_ADC_SAMPLES;
+	for (i = 0; i < count; i++)
+	{
+		value = samples[i];
+		for (j = i; j > 0 && sorted[j - 1] > value; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = value;
+	}
+	return sorted[count / 2];
+}
+
+// Key of an ADC value, held is the key pressed so far (hysteresis)
+uint8_t inputClassify(int value, uint8_t held)
+{
+	const KeyBand *band = &keyBands[held];
+
+	if (held != INPUT_NONE && value > band->low - INPUT_HYSTERESIS && value < band->high + INPUT_HYSTERESIS)
+		return held;
+
+	for (uint8_t key = INPUT_LEFT; key < INPUT_KEYS; key++)
+		if (value > keyBands[key].low && value < keyBands[key].high)
+			return key;
+	return INPUT_NONE;
+}
+
+// A full queue drops the new event
+static void push(uint8_t key, uint8_t pressed, uint32_t time)
+{
+	uint8_t next = (queueHead + 1) % INPUT_QUEUE_LEN;
+
+	if (next == queueTail)
+		return;
+	queue[queueHead].time = time;
+	queue[queueHead].key = key;
+	queue[queueHead].pressed = pressed;
+	// the event is complete before the consumer can see it
+	__DMB();
+	queueHead = next;
+	gEvents |= EVENT_INPUT;
+}
+
+// Filter the ADC buffer and classify it, called every tick from the SysTick interrupt
+void inputTick(uint32_t time)
+{
+	inputSample(inputMedian(gAdcSamples, INPUT_ADC_SAMPLES), time);
+}
+
+// Classify one filtered ADC sample and queue the debounced edges
+void inputSample(int value, uint32_t time)
+{
+	uint8_t key = inputClassify(value, heldKey);
+
+	if (key != candidateKey)
+	{
+		candidateKey = key;
+		candidateCount = 0;
+	}
+	if (candidateCount < INPUT_DEBOUNCE && ++candidateCount == INPUT_DEBOUNCE && key != heldKey)
+	{
+		if (heldKey != INPUT_NONE)
+			push(heldKey, 0, time);
+		if (key != INPUT_NONE)
+			push(key, 1, time);
+		heldKey = key;
+	}
+}
+
+// Take the oldest event, returns 0 when the queue is empty
+uint8_t inputPoll(InputEvent *event)
+{
+	if (queueTail == queueHead)
+		return 0;
+	*event = queue[queueTail];
+	__DMB();
+	queueTail = (queueTail + 1) % INPUT_QUEUE_LEN;
+	return 1;
+}
+
+// Take the oldest event only if it happened at or before time
+uint8_t inputPollUntil(InputEvent *event, uint32_t time)
+{
+	if (queueTail == queueHead || (int32_t)(queue[queueTail].time - time) > 0)
+		return 0;
+	return inputPoll(event);
+}
+
+// The debounced key held right now
+uint8_t inputHeld(void)
+{
+	return heldKey;
+}
+
+// Drop the queued events, a new screen does not get the keys of the old one
+void inputFlush(void)
+{
+	queueTail = queueHead;
+}
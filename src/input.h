@@ -0,0 +1,42 @@
+/*
+ * input.h
+ *
+ * Keys of the resistor ladder keypad on the ADC. ADC1 fills a circular
+ * DMA buffer, the SysTick interrupt takes its median, classifies it into
+ * a key and queues press and release events for the main loop.
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+
+#define INPUT_NONE		0
+#define INPUT_LEFT		1
+#define INPUT_RIGHT		2
+#define INPUT_DOWN		3
+#define INPUT_ROTATE	4
+#define INPUT_KEYS		5
+
+// Size of the circular ADC buffer, its median is one key sample
+#define INPUT_ADC_SAMPLES	16
+
+typedef struct {
+	uint32_t time;		// gTicks of the edge
+	uint8_t key;
+	uint8_t pressed;	// 1 press, 0 release
+} InputEvent;
+
+// Filled by DMA1 channel 1, set up in adc_init()
+extern volatile uint16_t gAdcSamples[INPUT_ADC_SAMPLES];
+
+int inputMedian(const volatile uint16_t *samples, uint8_t count);
+uint8_t inputClassify(int value, uint8_t held);
+void inputTick(uint32_t time);
+void inputSample(int value, uint32_t time);
+uint8_t inputPoll(InputEvent *event);
+uint8_t inputPollUntil(InputEvent *event, uint32_t time);
+uint8_t inputHeld(void);
+void inputFlush(void);
+
+#endif /* INPUT_H_ */
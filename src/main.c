@@ -28,8 +28,13 @@
 #include <stddef.h>
 #include "stm32l1xx.h"
 #include "spi.h"
+#include "spidma.h"
 #include "ssd1306.h"
 #include "ili9163.h"
+#include "benchmark.h"
+#include "screen.h"
+#include "events.h"
+#include "input.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -573,6 +578,8 @@ unsigned char pic4[]=
 */
 
 int gTimeStamp = 0;
+volatile uint32_t gTicks = 0;				// 1 ms tiky zo SysTick
+volatile uint8_t gEvents = 0;				// udalosti z preruseni, pozri events.h
 
 void TIM2_IRQHandler(void){
 	if (TIM_GetITStatus(TIM2, TIM_IT_Update) == SET){
@@ -581,81 +588,286 @@ void TIM2_IRQHandler(void){
 	}
 }
 
-volatile int AD_value = 0;
+// Cas v spanku za poslednu celu sekundu v promile, pre debugger (rezerva CPU),
+// spolu s cakanim na DMA displeja v spidma
+volatile uint16_t gIdlePerMille = 0;
+static uint32_t idleCycles = 0, idleSecond = 0, idleDma = 0;
+
+// Funkcia vrati cas v taktoch jadra podla SysTick, pocita aj pocas spanku
+static uint32_t sysTickCycles(void){
+	uint32_t ticks, value;
+	do {
+		ticks = gTicks;
+		value = SysTick->VAL;
+	} while (ticks != gTicks);
+	return ticks * (SysTick->LOAD + 1) + SysTick->LOAD - value;
+}
+
+// Funkcia uspi jadro (Sleep), kym prerusenie nenastavi udalost, a zapocita cas v spanku
+static void sleepUntilEvent(void){
+	uint32_t start = sysTickCycles();
+
+	while (1){
+		// prerusenia su vypnute, aby udalost nemohla prist medzi kontrolou a WFI, WFI ich aj tak zobudi
+		__disable_irq();
+		if (gEvents){
+			__enable_irq();
+			break;
+		}
+		__WFI();
+		__enable_irq();
+	}
+	idleCycles += sysTickCycles() - start;
+
+	if (gTicks - idleSecond >= 1000){
+		idleCycles += dmaSleepSPI2() - idleDma;
+		idleDma = dmaSleepSPI2();
+		gIdlePerMille = idleCycles / (SystemCoreClock / 1000);
+		idleCycles = 0;
+		idleSecond = gTicks;
+	}
+}
+
+// Stav hry
+static uint8_t blockX[1000], xDir[1000], yDir[1000];
+static int8_t blockY[1000];
+static int odstRiad = 0, rotCheck = 0, run = 0, abcVolba = 0, nameIndex = 0, volba = 0, cisloTvaru = 0, cisObj = 0, score = 0;
+static char timeStr[7], ppmStr[8] = "0.0    ", scoreStr[7], odstRiadStr[7];
+static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+static int time = 0, ppm = 0;
+static int hScValues[] = {5000, 4000, 3000, 2000, 1000};
+static char* hScNames[] = { "Player1", "Player2" , "Player3", "Player4", "Player5"};
+static char currName[7] = "NONAME", newName[7] =  "";
+
+// Obrazovky podla hodnoty run
+static const Screen screens[5];
+
+// Funkcia prepne obrazovku, ak funkcie hry zmenili hodnotu run
+static void changeRun(int current){
+	if (run != current)
+		screenChange(&screens[run]);
+}
+
+// Funkcia vrati nahodne cislo pre dalsi objekt: surova vzorka ADC (sum) a cas
+static uint32_t randomSeed(void){
+	return gAdcSamples[gTicks % INPUT_ADC_SAMPLES] + gTicks;
+}
+
+// Funkcia vrati tlacidlo najblizsieho stlacenia z fronty udalosti, pustenia preskoci,
+// INPUT_NONE ak je fronta prazdna
+static int nextPress(void){
+	InputEvent event;
+	while (inputPoll(&event))
+		if (event.pressed)
+			return event.key;
+	return INPUT_NONE;
+}
+
+// Main menu
+static void menuEnter(void){
+	drawMenuTitle();
+}
+
+static void menuUpdate(uint32_t dt){
+	int key;
+	while (run == 0 && (key = nextPress()) != INPUT_NONE){
+		int novaVolba = returnVolba(key, volba);	// vrati hodnotu vybranej volby
+		if (novaVolba != volba){
+			volba = novaVolba;
+			screenInvalidate();
+		}
+		run = returnRun(key, volba, run);		// vrati volbu dalsieho okna
+	}
+	changeRun(0);
+}
+
+static void menuRender(uint8_t dirty){
+	if (dirty)
+		drawMenu(volba);				// vypise volby, zvolena je zvyraznena
+}
+
+// Play game
+// Hra bezi v pevnych krokoch po 1 ms tiku nezavisle od rychlosti vykreslovania,
+// casy su v tikoch, gravityTicks sa moze menit podla urovne
+#define DAS_TICKS			170			// drzany posun dolava/doprava sa zacne opakovat po tomto case
+#define ARR_TICKS			50			// a potom sa opakuje s touto periodou
+#define GRAVITY_TICKS		100			// posun objektu o riadok nizsie
+#define SOFT_DROP_FACTOR	10			// kolkokrat rychlejsie pada objekt pri drzani tlacidla dole
+#define HARD_DROP_TICKS		250			// dve stlacenia dole v tomto case objekt hned zhodia
+#define LOCK_TICKS			100			// ako dlho objekt lezi na prekazke, kym sa polozi
+#define MAX_CATCHUP_TICKS	250			// po dlhom vykreslovani sa dobehne najviac tolko tikov
+
+static uint32_t gravityTimer = 0, lockTimer = 0;
+static uint32_t gravityTicks = GRAVITY_TICKS;
+static uint32_t gameTime = 0;					// gTicks, po ktory hra dobehla
+static uint32_t shiftTime = 0, downTime = 0;	// cas dalsieho opakovania posunu a posledneho stlacenia dole
+static int gameKey = INPUT_NONE;				// tlacidlo drzane v case gameTime
+
+static void gameEnter(void){
+	gTimeStamp = 0;
+	gameTime = gTicks;
+	gravityTimer = lockTimer = 0;
+	gameKey = INPUT_NONE;
+	downTime = gameTime - HARD_DROP_TICKS;
+	createText(currName);						// vypise texty na lavej strane
+	markDirty(BOARD_X - 1, 0, BOARD_X + BOARD_COLS * CELL_SIZE, 127);	// obrazovka bola vycistena, prekresli celu hraciu plochu
+}
+
+// Jeden tik hry, aktualny objekt je pocas tiku vymazany z hracej plochy
+static void gameTick(void){
+	InputEvent event;
+
+	// stlacenie sa vykona v tiku, v ktorom nastalo, casy sa pocitaju od casu udalosti
+	while (inputPollUntil(&event, gameTime)){
+		if (!event.pressed){
+			if (event.key == gameKey)
+				gameKey = INPUT_NONE;
+			continue;
+		}
+		gameKey = event.key;
+		if (event.key == INPUT_DOWN){
+			// druhe rychle stlacenie dole: objekt hned dopadne a polozi sa
+			if (event.time - downTime < HARD_DROP_TICKS){
+				blockY[cisObj] = dropRow(board, blockX[cisObj], blockY[cisObj], cisloTvaru);
+				lockTimer = LOCK_TICKS;
+			}
+			downTime = event.time;
+		}
+		else {
+			rotCheck = 0;						// rotacia iba raz na jedno stlacenie
+			buttonPressed(event.key, &xDir[cisObj], board, &blockX[cisObj], &blockY[cisObj], &cisloTvaru, &rotCheck);
+			shiftTime = event.time + DAS_TICKS;
+		}
+	}
+	// drzany posun dolava/doprava sa opakuje po DAS_TICKS kazdych ARR_TICKS
+	if ((gameKey == INPUT_LEFT || gameKey == INPUT_RIGHT) && (int32_t)(gameTime - shiftTime) >= 0){
+		buttonPressed(gameKey, &xDir[cisObj], board, &blockX[cisObj], &blockY[cisObj], &cisloTvaru, &rotCheck);
+		shiftTime += ARR_TICKS;
+	}
+
+	if (!checkBlockade(board, blockX[cisObj], blockY[cisObj], cisloTvaru)){
+		lockTimer = 0;
+		gravityTimer += (gameKey == INPUT_DOWN) ? SOFT_DROP_FACTOR : 1;	// soft drop iba zrychli gravitaciu
+		if (gravityTimer >= gravityTicks){
+			gravityTimer = 0;
+			blockY[cisObj] += yDir[cisObj];		// posuva objekt smerom dole
+		}
+	}
+	else if (++lockTimer >= LOCK_TICKS){
+		lockTimer = gravityTimer = 0;
+		checkObstacleAndGameOver(board, &blockX[cisObj], &blockY[cisObj], &cisloTvaru, &yDir[cisObj], &run, &cisObj, randomSeed());	// polozi objekt, Checkuje Game over
+		updateText(&score, board, &odstRiad, scoreStr, odstRiadStr, &time, timeStr, &ppm, ppmStr, gTimeStamp);	// vymaze plne riadky skor, ako sa pohne dalsi objekt
+	}
+}
+
+static void gameUpdate(uint32_t dt){
+	if (dt > MAX_CATCHUP_TICKS){
+		gameTime += dt - MAX_CATCHUP_TICKS;	// preskocene tiky
+		dt = MAX_CATCHUP_TICKS;
+	}
+
+	createDeleteBlock(board, blockX[cisObj], blockY[cisObj], cisloTvaru, 0);		// vymaze aktualny objekt
+	while (dt-- && run == 1){
+		gameTime++;
+		gameTick();
+	}
+	updateText(&score, board, &odstRiad, scoreStr, odstRiadStr, &time, timeStr, &ppm, ppmStr, gTimeStamp);	// aktualizuje hodnoty na lavej strane
+	createDeleteBlock(board, blockX[cisObj], blockY[cisObj], cisloTvaru, 1);	// vykresli aktualny objekt
+	changeRun(1);
+}
+
+static void gameRender(uint8_t dirty){
+	matrixPlot(board, cisloTvaru);				// posle zmenene casti hracej plochy
+}
+
+// Change my name
+static void nameEnter(void){
+	drawOldName(currName);						// vypise aktualne meno
+}
 
-void ADC1_IRQHandler(void) {
-	if (ADC1->SR & ADC_SR_EOC) {
-		AD_value = ADC1->DR;
+static void nameUpdate(uint32_t dt){
+	int key;
+	while (run == 2 && (key = nextPress()) != INPUT_NONE){
+		int novaVolba = returnAbcVolba(key, abcVolba);	// umoznuje prechadzanie medzi pismenami
+		if (novaVolba != abcVolba){
+			abcVolba = novaVolba;
+			screenInvalidate();
+		}
+		changeName(key, abcVolba, &nameIndex, newName, &run, currName);	// umoznuje vybrat si pismena a nastavit nove meno
 	}
+	changeRun(2);
 }
 
+static void nameRender(uint8_t dirty){
+	if (dirty)
+		drawABC(abcVolba);						// vykresli abc na obrazovke
+}
+
+// High score
+static void highscoreEnter(void){
+	showHighscore(hScValues, hScNames);		// vypise High Score s menami
+}
+
+static void highscoreUpdate(uint32_t dt){
+	run = goBack(nextPress(), run);				// vrati spat na hlavnu stranku
+	changeRun(3);
+}
+
+// Game over
+static void gameOverEnter(void){
+	drawGameOver(scoreStr, score, hScValues, hScNames, currName, timeStr, ppmStr);	// vypise Game over a ziskane vysledky
+}
+
+static void gameOverUpdate(uint32_t dt){
+	clearData(nextPress(), &score, &time, &odstRiad, &ppm, &run, blockX, blockY, xDir, yDir, &cisObj, board, ppmStr);	// resetuje pociatocne parametre
+	changeRun(4);
+}
+
+static const Screen screens[5] = {
+	{ menuEnter, menuUpdate, menuRender, NULL },
+	{ gameEnter, gameUpdate, gameRender, NULL },
+	{ nameEnter, nameUpdate, nameRender, NULL },
+	{ highscoreEnter, highscoreUpdate, NULL, NULL },
+	{ gameOverEnter, gameOverUpdate, NULL, NULL },
+};
+
 int main(void)
 {
 	adc_init();
 	startupNVIC();
 	initBaseTimer();
-	ADC_ITConfig(ADC1, ADC_IT_EOC, ENABLE);
 	initSPI2();
+	initDmaSPI2();
 	initCD_Pin();
 	initCS_Pin();
 	initRES_Pin();
 	lcdInitialise(LCD_ORIENTATION0); 				// inicialiyuje LCD
 	lcdClearDisplay(decodeRgbValue(0, 0, 0));   	// vycisti obrazovku
+#ifdef BENCHMARK
+	runBenchmarks();								// vypise vysledky meranii a zastavi sa
+#endif
 
   	// Pociatocne parametre
-  	uint8_t blockX[1000], blockY[1000], xDir[1000], yDir[1000];
-  	int odstRiad = 0, rotCheck = 0, run = 0, abcVolba = 0, nameIndex = 0, volba = 0, cisloTvaru = 0, cisObj = 0, score = 0;
-  	char timeStr[7], ppmStr[8] = "0      ", scoreStr[7], odstRiadStr[7];
-  	uint16_t matrix[128][128];
-  	float time = 0, ppm = 0;
-	int hScValues[] = {5000, 4000, 3000, 2000, 1000};
-  	char* hScNames[] = { "Player1", "Player2" , "Player3", "Player4", "Player5"};
-  	char currName[7] = "NONAME", newName[7] =  "";
+  	uint32_t lastTicks;
   	for (int i = 0; i < 1000; i++){ 		//vytvorenie objektov
-		blockX[i] = 81; blockY[i] = 0; xDir[i] = 6; yDir[i] = 6;
+		blockX[i] = BLOCK_START_X; blockY[i] = BLOCK_START_Y; xDir[i] = 1; yDir[i] = 1;
   	}
-  	createFrame(matrix); 					// vytvorenie ramy a vyplnit vsetko ine na ciernu farbu
-  	cisloTvaru = generateNumber(AD_value); 	// vygenerovanie cislo objektu
+  	createFrame(board); 					// vytvorenie ramy a vyprazdnenie hracej plochy
+  	cisloTvaru = generateNumber(randomSeed()); 	// vygenerovanie cislo objektu
+  	screenChange(&screens[0]);				// zacina sa v hlavnom menu
+  	SysTick_Config(SystemCoreClock / 1000);	// tik hry kazdu 1 ms
+  	dmaSetClockSPI2(sysTickCycles);			// spanok pri cakani na DMA sa rata do gIdlePerMille
+  	lastTicks = gTicks;
 
   /* Infinite loop */
   while (1)
   {
-	  // Main menu
-	  if (run == 0){
-		  drawMenu(AD_value, volba); 				// vypise texty a umoznuje pohyb medzi volbami
-		  volba = returnVolba(AD_value, volba);		// vrati hodnotu vybranej volby
-		  run = returnRun(AD_value, volba, run);	// vrati volbu dalsieho okna
-		  if (run == 1)
-			  gTimeStamp = 0;
-	  }
-	  // Play game
-	  else if (run == 1){
-		  createText(currName);						// vypise texty na lavej strane
-		  matrixPlot(matrix, cisloTvaru);			// v kazdom kroku aktualizuje maticu
-		  createDeleteBlock(matrix, blockX[cisObj], blockY[cisObj], cisloTvaru, 0);		// vymaze aktualny objekt
-		  blockY[cisObj] += yDir[cisObj];			// v kazdom kroku posuva objekt smerom dole
-		  buttonPressed(AD_value, &xDir[cisObj], matrix, &blockX[cisObj], &blockY[cisObj], &cisloTvaru, &rotCheck);	// rozhoduje o tom co ma robit, ak gombiky su tlacene
-		  updateText(&score, matrix, &odstRiad, scoreStr, odstRiadStr, &time, timeStr, &ppm, ppmStr, gTimeStamp);	// aktualizuje hodnoty na lavej strane
-		  checkObstacleAndGameOver(matrix, &blockX[cisObj], &blockY[cisObj], &cisloTvaru, &yDir[cisObj], &run, &cisObj, AD_value);	// Checkuje prekazku a Game over
-		  createDeleteBlock(matrix, blockX[cisObj], blockY[cisObj], cisloTvaru, 1);	// vykresli aktualny objekt
-		  rotCheck = 0;								// zabezpecuje aby rotacia mohla nastat v kazdom cykle iba raz
-	  }
-	  // Change my name
-	  else if (run == 2){
-		  drawABC(abcVolba, currName); 						// vykresli abc na obrazovke
-		  abcVolba = returnAbcVolba(AD_value, abcVolba);	// umoznuje prechadzanie medzi pismenami
-		  changeName(AD_value, abcVolba, &nameIndex, newName, &run, currName);	// umoznuje vybrat si pismena a nastavit nove meno
-	  }
-	  // High score
-	  else if (run == 3){
-		  showHighscore(hScValues, hScNames);		// vypise High Score s menami
-		  run = goBack(AD_value, run);				// vrati spat na hlavnu stranku
-	  }
-	  // Game over
-	  else if (run == 4){
-		  drawGameOver(scoreStr, score, hScValues, hScNames, currName, timeStr, ppmStr);	// vypise Game over a ziskane vysledky
-		  clearData(AD_value, &score, &time, &odstRiad, &ppm, &run, blockX, blockY, xDir, yDir, &cisObj, matrix, ppmStr);	// resetuje pociatocne parametre
-	  }
+	  // obrazovka podla run spracuje vstup a prekresli zmenene casti
+	  sleepUntilEvent();						// spi, kym nepride tik alebo zmena tlacidiel
+	  gEvents = 0;
+	  uint32_t ticks = gTicks;
+	  screenStep(ticks - lastTicks);
+	  lastTicks = ticks;
   }
   return 0;
 }
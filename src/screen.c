@@ -0,0 +1,58 @@
+/*
+ * screen.c
+ *
+ * Screen state machine, see screen.h.
+ */
+
+#include <stddef.h>
+#include "screen.h"
+#include "ili9163.h"
+#include "input.h"
+
+static const Screen *current = NULL;
+static const Screen *pending = NULL;
+static uint8_t dirty = 0;
+
+// Request a transition, it happens at the start of the next screenStep()
+void screenChange(const Screen *next)
+{
+	pending = next;
+}
+
+// The next render() gets dirty = 1
+void screenInvalidate(void)
+{
+	dirty = 1;
+}
+
+// One pass of the main loop: a pending transition, then update() and
+// render() of the current screen and the text buffer flush. A screen that
+// requests a transition in update() is not rendered again, the input
+// events it left in the queue are dropped.
+void screenStep(uint32_t dt)
+{
+	if (pending != NULL)
+	{
+		if (current != NULL && current->exit != NULL)
+			current->exit();
+		lcdClearDisplay(decodeRgbValue(0, 0, 0));
+		inputFlush();
+		current = pending;
+		pending = NULL;
+		dirty = 1;
+		if (current->enter != NULL)
+			current->enter();
+	}
+	if (current == NULL)
+		return;
+
+	if (current->update != NULL)
+		current->update(dt);
+	if (pending != NULL)
+		return;
+
+	if (current->render != NULL)
+		current->render(dirty);
+	dirty = 0;
+	textFlush();
+}
@@ -0,0 +1,27 @@
+/*
+ * screen.h
+ *
+ * Screen state machine. Each screen draws its static content in enter(),
+ * reacts to the input events in update() and redraws its changing parts
+ * in render().
+ * All transitions go through screenChange(), the screen is cleared once
+ * between exit() of the old and enter() of the new screen.
+ */
+
+#ifndef SCREEN_H_
+#define SCREEN_H_
+
+#include <stdint.h>
+
+typedef struct {
+	void (*enter)(void);
+	void (*update)(uint32_t dt);
+	void (*render)(uint8_t dirty);
+	void (*exit)(void);
+} Screen;
+
+void screenChange(const Screen *next);
+void screenInvalidate(void);
+void screenStep(uint32_t dt);
+
+#endif /* SCREEN_H_ */
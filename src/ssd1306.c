@@ -7,6 +7,7 @@
 
 #include "ssd1306.h"
 #include "spi.h"
+#include "spidma.h"
 
 uint8_t Contrast_level=0xf0;
 
@@ -38,18 +39,12 @@ void display_Contrast_level(uint8_t number)
 }
 
 void Write_number(uint8_t *n,uint8_t k,uint8_t station_dot)
-{uint8_t i;
-			for(i=0;i<8;i++)
-				{
-				Write_Data(*(n+16*k+i));
-				}
+{
+	Write_Data_Block(n+16*k, 8);
 
 	Set_Page_Address(Start_page+1)	;
     Set_Column_Address(Start_column+station_dot*8);
-			for(i=8;i<16;i++)
-				{
-				Write_Data(*(n+16*k+i));
-				}
+	Write_Data_Block(n+16*k+8, 8);
 }
 
 void Delay(uint16_t n)
@@ -65,18 +60,34 @@ void Delay(uint16_t n)
 
 void Write_Data(unsigned char dat)
 {
+	dmaWaitSPI2();
+	setFrameSizeSPI2(0);
 	cd_set();
 	device_Select();
 
-	readWriteSPI2(dat);
+	writeSPI2(dat);
+	flushSPI2();
 	device_Unselect();
 }
 
 
 
 
+// Queue a block of display data, the data must stay valid until it is sent.
+// The DMA interrupt selects the device when the block starts and releases
+// it after the last of consecutive blocks.
+void Write_Data_Block(const unsigned char *dat, uint16_t count)
+{
+	cd_set();
+
+	dmaWriteSPI2(dat, count, SPI_DMA_SELECT, 0);
+}
+
 void Write_Instruction(unsigned char cmd)
 {
+	dmaWaitSPI2();
+	setFrameSizeSPI2(0);
+	flushSPI2();
 	cd_reset();
 	device_Select();
 
@@ -170,9 +181,12 @@ void ssd1306_init(void)
 
 void Display_Chess(unsigned char value)
 {
+    static unsigned char page[0x80];
     unsigned char i,j,k;
+
     for(i=0;i<0x08;i++)
 	{
+		// waits for the previous page, so the buffer is free again
 		Set_Page_Address(i);
 
         Set_Column_Address(0x00);
@@ -180,10 +194,11 @@ void Display_Chess(unsigned char value)
 		for(j=0;j<0x10;j++)
 		{
 		    for(k=0;k<0x04;k++)
-		        Write_Data(value);
+		        page[j*8+k] = value;
 		    for(k=0;k<0x04;k++)
-		        Write_Data(~value);
+		        page[j*8+4+k] = ~value;
 		}
+		Write_Data_Block(page, 0x80);
 	}
     return;
 }
@@ -191,7 +206,7 @@ void Display_Chess(unsigned char value)
 
 void Display_Chinese(unsigned char ft[])
 {
-    unsigned char i,j,k,b,c=0;
+    unsigned char i,j,b,c=0;
 	unsigned int	num=0;
 
 for(b=0;b<4;b++)
@@ -202,10 +217,7 @@ for(b=0;b<4;b++)
 	    num=i*0x10+b*256;
 		for(j=0;j<0x08;j++)
 		{
-            for(k=0;k<0x10;k++)
-			{
-		        Write_Data(ft[num+k]);
-			}
+		    Write_Data_Block(&ft[num], 0x10);
 			num+=0x20;
 		}c++;
 	}
@@ -217,17 +229,14 @@ for(b=0;b<4;b++)
 //Display_Chinese1
 void Display_Chinese_Column(unsigned char ft[])
 {
-    unsigned char i,j,k,num=0x40;
+    unsigned char i,j,num=0x40;
     for(i=0;i<0x08;i++)
 	{
 		Set_Page_Address(i);
         Set_Column_Address(0x00);
 		for(j=0;j<0x08;j++)
 		{
-            for(k=0;k<0x10;k++)
-			{
-		        Write_Data(ft[num+k]);
-			}
+		    Write_Data_Block(&ft[num], 0x10);
 		}
 	num+=0x10;
 	}
@@ -237,15 +246,12 @@ void Display_Chinese_Column(unsigned char ft[])
 
 void Display_Picture(unsigned char pic[])
 {
-    unsigned char i,j,num=0;
+    unsigned char i;
 	for(i=0;i<0x08;i++)
 	{
 	Set_Page_Address(i);
     Set_Column_Address(0x00);
-        for(j=0;j<0x80;j++)
-		{
-		    Write_Data(pic[i*0x80+j]);
-		}
+	Write_Data_Block(&pic[i*0x80], 0x80);
 	}
     return;
 }
@@ -20,6 +20,7 @@ void display_Contrast_level(uint8_t number);
 void adj_Contrast(void);
 void Delay(uint16_t n);
 void Write_Data(unsigned char dat);
+void Write_Data_Block(const unsigned char *dat, uint16_t count);
 void Write_Instruction(unsigned char cmd);
 void Set_Page_Address(unsigned char add);
 void Set_Column_Address(unsigned char add);
@@ -0,0 +1,104 @@
+/*
+ * stats.c
+ *
+ * Integer game statistics and number formatting without sprintf or float.
+ * The formatters write the number left aligned into a caller buffer, pad
+ * it with spaces to size - 1 characters and terminate it.
+ */
+
+#include "stats.h"
+
+// "00" to "99", two digits per table lookup
+static const char digitPairs[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+// Rate per minute in tenths, amount * 60 / seconds with one decimal place
+// truncated like the float version did. 0 before the first second, rates
+// beyond 32 bits saturate.
+uint32_t statsPerMinuteTenths(uint32_t amount, uint32_t seconds)
+{
+	uint64_t tenths;
+
+	if (seconds == 0)
+		return 0;
+	tenths = (uint64_t)amount * 600 / seconds;
+	return (tenths > UINT32_MAX) ? UINT32_MAX : tenths;
+}
+
+// Write the digits of value at the end of digits[10], return the count
+static uint8_t statsDigits(char digits[10], uint32_t value)
+{
+	char *p = digits + 10;
+	uint32_t pair;
+
+	while (value >= 100)
+	{
+		pair = (value % 100) * 2;
+		value /= 100;
+		*--p = digitPairs[pair + 1];
+		*--p = digitPairs[pair];
+	}
+	if (value >= 10)
+	{
+		pair = value * 2;
+		*--p = digitPairs[pair + 1];
+		*--p = digitPairs[pair];
+	}
+	else
+		*--p = '0' + value;
+
+	return digits + 10 - p;
+}
+
+// Copy count characters and pad the rest of the buffer, returns the length
+// of the number (without the padding)
+static uint8_t statsCopy(char *buffer, uint8_t size, const char *text, uint8_t count)
+{
+	uint8_t i;
+
+	if (count > size - 1)
+		count = size - 1;
+	for (i = 0; i < count; i++)
+		buffer[i] = text[i];
+	for (; i < size - 1; i++)
+		buffer[i] = ' ';
+	buffer[size - 1] = '\0';
+	return count;
+}
+
+uint8_t formatStatsUint(char *buffer, uint8_t size, uint32_t value)
+{
+	char digits[10];
+	uint8_t count = statsDigits(digits, value);
+
+	return statsCopy(buffer, size, digits + 10 - count, count);
+}
+
+// Write tenths as "<whole>.<tenth>", values above 99999.9 are clamped
+uint8_t formatStatsTenths(char *buffer, uint8_t size, uint32_t tenths)
+{
+	char text[12];
+	char digits[10];
+	uint8_t count, i;
+
+	if (tenths > STATS_TENTHS_MAX)
+		tenths = STATS_TENTHS_MAX;
+
+	count = statsDigits(digits, tenths / 10);
+	for (i = 0; i < count; i++)
+		text[i] = digits[10 - count + i];
+	text[count++] = '.';
+	text[count++] = '0' + tenths % 10;
+
+	return statsCopy(buffer, size, text, count);
+}
@@ -0,0 +1,19 @@
+/*
+ * stats.h
+ *
+ * Integer game statistics and number formatting without sprintf or float.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+
+// Largest rate formatStatsTenths() prints, 99999.9
+#define STATS_TENTHS_MAX	999999UL
+
+uint32_t statsPerMinuteTenths(uint32_t amount, uint32_t seconds);
+uint8_t formatStatsUint(char *buffer, uint8_t size, uint32_t value);
+uint8_t formatStatsTenths(char *buffer, uint8_t size, uint32_t tenths);
+
+#endif /* STATS_H_ */
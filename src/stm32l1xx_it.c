@@ -24,6 +24,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l1xx_it.h"
 /* #include "main.h" */
+#include "events.h"
+#include "input.h"
 
 /** @addtogroup Template_Project
   * @{
@@ -135,6 +137,9 @@ void PendSV_Handler(void)
   */
 void SysTick_Handler(void)
 {
+	gTicks++;
+	gEvents |= EVENT_TICK;
+	inputTick(gTicks);
 	/*  TimingDelay_Decrement(); */
 #ifdef USE_STM32L_DISCOVERY
   TimingDelay_Decrement();
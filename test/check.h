@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    test/check.h
+  * @brief   Minimal assertions for the host tests.
+  ******************************************************************************
+  */
+
+#ifndef __CHECK_H
+#define __CHECK_H
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+		checkFailures++; \
+	} \
+} while(0)
+
+#define CHECK_EQ(a, b) do { \
+	long long checkA = (long long)(a), checkB = (long long)(b); \
+	if (checkA != checkB) { \
+		printf("%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, checkA, checkB); \
+		checkFailures++; \
+	} \
+} while(0)
+
+// Print the verdict, the result is the exit code of the test program
+static int checkReport(const char *name)
+{
+	if (checkFailures)
+		printf("%s: %d check(s) FAILED\n", name, checkFailures);
+	else
+		printf("%s: ok\n", name);
+	return checkFailures != 0;
+}
+
+#endif
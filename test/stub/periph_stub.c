@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file    test/stub/periph_stub.c
+  * @brief   Do-nothing versions of the StdPeriph calls made while the game
+  *          sets up the ADC and TIM2, and the event
+  *          flags main.c owns.
+  ******************************************************************************
+  */
+
+#include "stm32l1xx.h"
+#include "events.h"
+
+ADC_TypeDef stubAdc1;
+GPIO_TypeDef stubGpioA;
+TIM_TypeDef stubTim2;
+DMA_Channel_TypeDef stubDma1Channel1;
+uint32_t SystemCoreClock = 32000000;
+
+// Defined by main.c on the target
+volatile uint32_t gTicks = 0;
+volatile uint8_t gEvents = 0;
+
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+	(void)NVIC_PriorityGroup;
+}
+
+void RCC_HSICmd(FunctionalState NewState)
+{
+	(void)NewState;
+}
+
+FlagStatus RCC_GetFlagStatus(uint8_t RCC_FLAG)
+{
+	(void)RCC_FLAG;
+	return SET;
+}
+
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState)
+{
+	(void)RCC_APB1Periph;
+	(void)NewState;
+}
+
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+	(void)RCC_APB2Periph;
+	(void)NewState;
+}
+
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct)
+{
+	(void)GPIOx;
+	(void)GPIO_InitStruct;
+}
+
+void DMA_DeInit(DMA_Channel_TypeDef *DMAy_Channelx)
+{
+	(void)DMAy_Channelx;
+}
+
+void DMA_Init(DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct)
+{
+	(void)DMAy_Channelx;
+	(void)DMA_InitStruct;
+}
+
+void DMA_Cmd(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState)
+{
+	(void)DMAy_Channelx;
+	(void)NewState;
+}
+
+void ADC_StructInit(ADC_InitTypeDef *ADC_InitStruct)
+{
+	(void)ADC_InitStruct;
+}
+
+void ADC_Init(ADC_TypeDef *ADCx, ADC_InitTypeDef *ADC_InitStruct)
+{
+	(void)ADCx;
+	(void)ADC_InitStruct;
+}
+
+void ADC_RegularChannelConfig(ADC_TypeDef *ADCx, uint8_t ADC_Channel, uint8_t Rank, uint8_t ADC_SampleTime)
+{
+	(void)ADCx;
+	(void)ADC_Channel;
+	(void)Rank;
+	(void)ADC_SampleTime;
+}
+
+void ADC_DMARequestAfterLastTransferCmd(ADC_TypeDef *ADCx, FunctionalState NewState)
+{
+	(void)ADCx;
+	(void)NewState;
+}
+
+void ADC_DMACmd(ADC_TypeDef *ADCx, FunctionalState NewState)
+{
+	(void)ADCx;
+	(void)NewState;
+}
+
+void ADC_Cmd(ADC_TypeDef *ADCx, FunctionalState NewState)
+{
+	(void)ADCx;
+	(void)NewState;
+}
+
+FlagStatus ADC_GetFlagStatus(ADC_TypeDef *ADCx, uint16_t ADC_FLAG)
+{
+	(void)ADCx;
+	(void)ADC_FLAG;
+	return SET;
+}
+
+void ADC_SoftwareStartConv(ADC_TypeDef *ADCx)
+{
+	(void)ADCx;
+}
+
+void TIM_TimeBaseInit(TIM_TypeDef *TIMx, TIM_TimeBaseInitTypeDef *TIM_TimeBaseInitStruct)
+{
+	(void)TIMx;
+	(void)TIM_TimeBaseInitStruct;
+}
+
+void TIM_ITConfig(TIM_TypeDef *TIMx, uint16_t TIM_IT, FunctionalState NewState)
+{
+	(void)TIMx;
+	(void)TIM_IT;
+	(void)NewState;
+}
+
+void TIM_Cmd(TIM_TypeDef *TIMx, FunctionalState NewState)
+{
+	(void)TIMx;
+	(void)NewState;
+}
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file    test/stub/spi_stub.c
+  * @brief   Host version of mcu/spi.c, the CPU driven transfers go straight
+  *          into the frame log of the stub.
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include "spi.h"
+#include "stm32l1xx.h"
+#include "stub.h"
+
+static void writeFrame(uint16_t value)
+{
+	if (DMA1_Channel3->CCR & DMA_CCR1_EN)
+	{
+		printf("stub: CPU write while the DMA owns SPI1\n");
+		stubErrors++;
+	}
+	stubLogFrame(value, (SPI1->CR1 & SPI_CR1_DFF) != 0, 0);
+}
+
+void initSPI2(void)
+{
+}
+
+unsigned char readWriteSPI2(unsigned char txData)
+{
+	writeFrame(txData);
+	return 0;
+}
+
+void setFrameSizeSPI2(uint8_t wide)
+{
+	uint16_t dff = wide ? SPI_CR1_DFF : 0;
+
+	if ((SPI1->CR1 & SPI_CR1_DFF) == dff)
+		return;
+
+	if (DMA1_Channel3->CCR & DMA_CCR1_EN)
+	{
+		printf("stub: SPI frame size changed during a DMA transfer\n");
+		stubErrors++;
+	}
+	SPI1->CR1 = (SPI1->CR1 & ~SPI_CR1_DFF) | dff;
+}
+
+void writeSPI2(unsigned char txData)
+{
+	writeFrame(txData);
+}
+
+void writeWordSPI2(uint16_t txData)
+{
+	writeFrame(txData);
+}
+
+void flushSPI2(void)
+{
+}
+
+void writePixelsSPI2(const uint16_t *pixels, uint32_t count)
+{
+	while(count--)
+		writeFrame(*pixels++);
+}
+
+void fillPixelsSPI2(uint16_t colour, uint32_t count)
+{
+	while(count--)
+		writeFrame(colour);
+}
+
+void initCS_Pin(void)
+{
+}
+
+void device_Select(void)
+{
+	stubSelected = 1;
+}
+
+void device_Unselect(void)
+{
+	stubSelected = 0;
+}
+
+void initCD_Pin(void)
+{
+}
+
+void cd_set(void)
+{
+	stubData = 1;
+}
+
+void cd_reset(void)
+{
+	stubData = 0;
+}
+
+void initRES_Pin(void)
+{
+}
+
+void res_set(void)
+{
+}
+
+void res_reset(void)
+{
+}
@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file    test/stub/stm32l1xx.h
+  * @brief   Host stand-in for the device header. Only the DMA1 and SPI1
+  *          registers the drivers touch are modelled, stub.c moves the data.
+  ******************************************************************************
+  */
+
+#ifndef __STM32L1XX_H
+#define __STM32L1XX_H
+
+#include <stdint.h>
+
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {RESET = 0, SET = !RESET} FlagStatus;
+
+typedef struct
+{
+	volatile uint32_t CCR;
+	volatile uint32_t CNDTR;
+	volatile uint32_t CPAR;
+	volatile uint32_t CMAR;
+}DMA_Channel_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t ISR;
+	volatile uint32_t IFCR;
+}DMA_TypeDef;
+
+typedef struct
+{
+	volatile uint16_t CR1;
+	volatile uint16_t CR2;
+	volatile uint16_t SR;
+	volatile uint16_t DR;
+}SPI_TypeDef;
+
+typedef enum
+{
+	DMA1_Channel1_IRQn = 11,
+	DMA1_Channel3_IRQn = 13,
+	TIM2_IRQn = 28
+}IRQn_Type;
+
+typedef struct
+{
+	uint8_t NVIC_IRQChannel;
+	uint8_t NVIC_IRQChannelPreemptionPriority;
+	uint8_t NVIC_IRQChannelSubPriority;
+	FunctionalState NVIC_IRQChannelCmd;
+}NVIC_InitTypeDef;
+
+extern DMA_TypeDef stubDma1;
+extern DMA_Channel_TypeDef stubDma1Channel3;
+extern SPI_TypeDef stubSpi1;
+
+#define DMA1			(&stubDma1)
+#define DMA1_Channel3	(&stubDma1Channel3)
+#define SPI1			(&stubSpi1)
+
+#define DMA_ISR_TCIF3		((uint32_t)0x00000200)
+#define DMA_IFCR_CGIF3		((uint32_t)0x00000100)
+#define DMA_CCR1_EN			((uint16_t)0x0001)
+#define DMA_CCR1_TCIE		((uint16_t)0x0002)
+#define DMA_CCR1_DIR		((uint16_t)0x0010)
+#define DMA_CCR1_MINC		((uint16_t)0x0080)
+#define DMA_CCR1_PSIZE_0	((uint16_t)0x0100)
+#define DMA_CCR1_MSIZE_0	((uint16_t)0x0400)
+#define DMA_CCR1_PL_1		((uint16_t)0x2000)
+
+#define SPI_CR1_SPE			((uint16_t)0x0040)
+#define SPI_CR1_DFF			((uint16_t)0x0800)
+#define SPI_CR2_TXDMAEN		((uint8_t)0x02)
+#define SPI_SR_TXE			((uint8_t)0x02)
+#define SPI_SR_BSY			((uint8_t)0x80)
+
+#define RCC_AHBPeriph_DMA1	((uint32_t)0x01000000)
+
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct);
+void RCC_AHBPeriphClockCmd(uint32_t RCC_AHBPeriph, FunctionalState NewState);
+
+// Peripherals the game only sets up (ADC, its DMA channel, TIM2), the
+// calls do nothing and the flags read as set
+typedef struct
+{
+	volatile uint32_t DR;
+}ADC_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t MODER;
+}GPIO_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t CR1;
+}TIM_TypeDef;
+
+typedef struct
+{
+	uint32_t GPIO_Pin;
+	uint32_t GPIO_Mode;
+	uint32_t GPIO_PuPd;
+}GPIO_InitTypeDef;
+
+typedef struct
+{
+	uint32_t ADC_Resolution;
+	FunctionalState ADC_ContinuousConvMode;
+	uint32_t ADC_ExternalTrigConvEdge;
+	uint32_t ADC_DataAlign;
+	uint8_t ADC_NbrOfConversion;
+}ADC_InitTypeDef;
+
+typedef struct
+{
+	uint32_t DMA_PeripheralBaseAddr;
+	uint32_t DMA_MemoryBaseAddr;
+	uint32_t DMA_DIR;
+	uint32_t DMA_BufferSize;
+	uint32_t DMA_PeripheralInc;
+	uint32_t DMA_MemoryInc;
+	uint32_t DMA_PeripheralDataSize;
+	uint32_t DMA_MemoryDataSize;
+	uint32_t DMA_Mode;
+	uint32_t DMA_Priority;
+	uint32_t DMA_M2M;
+}DMA_InitTypeDef;
+
+typedef struct
+{
+	uint16_t TIM_Prescaler;
+	uint16_t TIM_CounterMode;
+	uint32_t TIM_Period;
+	uint16_t TIM_ClockDivision;
+}TIM_TimeBaseInitTypeDef;
+
+extern ADC_TypeDef stubAdc1;
+extern GPIO_TypeDef stubGpioA;
+extern TIM_TypeDef stubTim2;
+extern DMA_Channel_TypeDef stubDma1Channel1;
+extern uint32_t SystemCoreClock;
+
+#define ADC1			(&stubAdc1)
+#define GPIOA			(&stubGpioA)
+#define TIM2			(&stubTim2)
+#define DMA1_Channel1	(&stubDma1Channel1)
+
+#define GPIO_Pin_0							0
+#define GPIO_Mode_AN						0
+#define GPIO_PuPd_NOPULL					0
+#define ADC_Channel_0						0
+#define ADC_DataAlign_Right					0
+#define ADC_ExternalTrigConvEdge_None		0
+#define ADC_FLAG_ADONS						0
+#define ADC_Resolution_12b					0
+#define ADC_SampleTime_384Cycles			0
+#define DMA_DIR_PeripheralSRC				0
+#define DMA_M2M_Disable						0
+#define DMA_MemoryDataSize_HalfWord			0
+#define DMA_MemoryInc_Enable				0
+#define DMA_Mode_Circular					0
+#define DMA_PeripheralDataSize_HalfWord		0
+#define DMA_PeripheralInc_Disable			0
+#define DMA_Priority_Low					0
+#define NVIC_PriorityGroup_0				0
+#define RCC_AHBPeriph_GPIOA					0
+#define RCC_APB1Periph_TIM2					0
+#define RCC_APB2Periph_ADC1					0
+#define RCC_FLAG_HSIRDY						0
+#define TIM_CounterMode_Up					0
+#define TIM_IT_Update						0
+
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup);
+void RCC_HSICmd(FunctionalState NewState);
+FlagStatus RCC_GetFlagStatus(uint8_t RCC_FLAG);
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState);
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState);
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct);
+void DMA_DeInit(DMA_Channel_TypeDef *DMAy_Channelx);
+void DMA_Init(DMA_Channel_TypeDef *DMAy_Channelx, DMA_InitTypeDef *DMA_InitStruct);
+void DMA_Cmd(DMA_Channel_TypeDef *DMAy_Channelx, FunctionalState NewState);
+void ADC_StructInit(ADC_InitTypeDef *ADC_InitStruct);
+void ADC_Init(ADC_TypeDef *ADCx, ADC_InitTypeDef *ADC_InitStruct);
+void ADC_RegularChannelConfig(ADC_TypeDef *ADCx, uint8_t ADC_Channel, uint8_t Rank, uint8_t ADC_SampleTime);
+void ADC_DMARequestAfterLastTransferCmd(ADC_TypeDef *ADCx, FunctionalState NewState);
+void ADC_DMACmd(ADC_TypeDef *ADCx, FunctionalState NewState);
+void ADC_Cmd(ADC_TypeDef *ADCx, FunctionalState NewState);
+FlagStatus ADC_GetFlagStatus(ADC_TypeDef *ADCx, uint16_t ADC_FLAG);
+void ADC_SoftwareStartConv(ADC_TypeDef *ADCx);
+void TIM_TimeBaseInit(TIM_TypeDef *TIMx, TIM_TimeBaseInitTypeDef *TIM_TimeBaseInitStruct);
+void TIM_ITConfig(TIM_TypeDef *TIMx, uint16_t TIM_IT, FunctionalState NewState);
+void TIM_Cmd(TIM_TypeDef *TIMx, FunctionalState NewState);
+
+// The interrupt mask only matters to the simulation: WFI runs the
+// transfer on the bus to completion and calls its interrupt handler.
+void stubDisableIrq(void);
+void stubEnableIrq(void);
+void stubWfi(void);
+
+#define __disable_irq()	stubDisableIrq()
+#define __enable_irq()	stubEnableIrq()
+#define __WFI()			stubWfi()
+#define __DMB()			do {} while(0)
+
+#endif
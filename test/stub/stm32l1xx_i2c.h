@@ -0,0 +1 @@
+// Empty on the host, everything the tests need is in stm32l1xx.h
@@ -0,0 +1,44 @@
+/**
+  ******************************************************************************
+  * @file    test/stub/stub.h
+  * @brief   Inspection side of the host register stub: every frame put on
+  *          the simulated SPI1 bus is logged together with the CS/CD state.
+  ******************************************************************************
+  */
+
+#ifndef __STUB_H
+#define __STUB_H
+
+#include <stdint.h>
+
+#define STUB_FRAMES	0x20000
+
+typedef struct
+{
+	uint16_t value;
+	uint8_t wide;		// 16 bit frame
+	uint8_t selected;	// CS was low
+	uint8_t data;		// CD was high
+	uint8_t dma;		// sent by DMA1 channel 3
+}StubFrame;
+
+// Only the first STUB_FRAMES frames are kept, stubFrameCount and stubBytes
+// keep counting past that
+extern StubFrame stubFrames[STUB_FRAMES];
+extern uint32_t stubFrameCount;
+extern uint32_t stubBytes;
+extern uint8_t stubSelected;
+extern uint8_t stubData;
+
+// Register misuse seen by the simulation, e.g. a CPU write or a frame size
+// change while the DMA owns the bus
+extern uint32_t stubErrors;
+
+void stubReset(void);
+void stubLogFrame(uint16_t value, uint8_t wide, uint8_t dma);
+
+// Shift the whole DMA transfer out and run the interrupt handler,
+// returns 0 when no transfer was enabled
+uint8_t stubDmaComplete(void);
+
+#endif
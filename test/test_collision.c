@@ -0,0 +1,332 @@
+/**
+  ******************************************************************************
+  * @file    test/test_collision.c
+  * @brief   Equivalence of the row bitboard collision checks in ili9163.c
+  *          with the per-shape, per-cell checks they replaced, and a host
+  *          micro-benchmark of both.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "ili9163.h"
+
+#define SHAPES		19
+#define BOARDS		2000
+#define BENCH_ROUNDS	200
+
+static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+static uint32_t seed = 12345;
+static uint32_t mismatches;
+
+static uint32_t nextRandom(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7FFF;
+}
+
+// Reference: the cell board checks as they were before the bitboard, with
+// the shapes spelled out per orientation and rotateObject() from the start
+
+// Funkcia vrati sirku a vysku tvaru v bunkach
+static void refBlockSize(int cisloTvaru, int *w, int *h){
+	if (cisloTvaru == 0){
+		*w = 2; *h = 2;
+	}
+	else if (cisloTvaru == 1){
+		*w = 1; *h = 4;
+	}
+	else if (cisloTvaru == 2){
+		*w = 4; *h = 1;
+	}
+	else if (cisloTvaru == 3 || cisloTvaru == 5 || cisloTvaru == 8 || cisloTvaru == 10 || cisloTvaru == 11 || cisloTvaru == 13 || cisloTvaru == 16 || cisloTvaru == 18){
+		*w = 3; *h = 2;
+	}
+	else{
+		*w = 2; *h = 3;
+	}
+}
+
+// Funkcia vrati 1, ak bunka i (stlpec zlava) a j (riadok zdola) patri tvaru
+static int refBlockCell(int cisloTvaru, int i, int j){
+	int temp = 0;
+	// ak objekt je stvorec, obdlznik | alebo obdlznik _
+	if (cisloTvaru == 0 || cisloTvaru == 1 || cisloTvaru == 2)
+		temp = 1;
+	// ak objekt je Z
+	else if (cisloTvaru == 3)
+		temp = (j == 0 && i > 0) || (j == 1 && i < 2);
+	// ak objekt je N
+	else if (cisloTvaru == 4)
+		temp = (j > 0 && i == 1) || j == 1 || (j < 2 && i == 0);
+	// ak objekt je opacne Z
+	else if (cisloTvaru == 5)
+		temp = (j == 1 && i > 0) || (j == 0 && i < 2);
+	// ak objekt je opacny N
+	else if (cisloTvaru == 6)
+		temp = (j > 0 && i == 0) || j == 1 || (j < 2 && i == 1);
+	// ak objekt je L
+	else if (cisloTvaru == 7)
+		temp = i == 0 || j == 0;
+	// ak objekt je _.
+	else if (cisloTvaru == 8)
+		temp = j == 0 || i == 2;
+	// ak objekt je '|
+	else if (cisloTvaru == 9)
+		temp = i == 1 || j == 2;
+	// ak objekt je ,..
+	else if (cisloTvaru == 10)
+		temp = i == 0 || j == 1;
+	// ak objekt je _._
+	else if (cisloTvaru == 11)
+		temp = j == 0 || i == 1;
+	// ak objekt je -|
+	else if (cisloTvaru == 12)
+		temp = j == 1 || i == 1;
+	// ak objekt je ..,..
+	else if (cisloTvaru == 13)
+		temp = i == 1 || j == 1;
+	// ak objekt je |-
+	else if (cisloTvaru == 14)
+		temp = i == 0 || j == 1;
+	// ak objekt je opacny L
+	else if (cisloTvaru == 15)
+		temp = j == 0 || i == 1;
+	// ak objekt je ..,
+	else if (cisloTvaru == 16)
+		temp = i == 2 || j == 1;
+	// ak objekt je |'
+	else if (cisloTvaru == 17)
+		temp = i == 0 || j == 2;
+	// ak objekt je _.
+	else if (cisloTvaru == 18)
+		temp = j == 0 || i == 0;
+	return temp;
+}
+
+// Funkcia vykonava otocenie objektu
+static int refRotateObject(int cisloTvaru){
+	if (cisloTvaru == 1)
+		cisloTvaru += 1;
+	else if (cisloTvaru == 2)
+	  cisloTvaru -= 1;
+	else if (cisloTvaru == 3)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 4)
+	  cisloTvaru -= 1;
+	else if (cisloTvaru == 5)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 6)
+	  cisloTvaru -= 1;
+	else if (cisloTvaru == 7)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 8)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 9)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 10)
+	  cisloTvaru -= 3;
+	else if (cisloTvaru == 11)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 12)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 13)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 14)
+	  cisloTvaru -= 3;
+	else if (cisloTvaru == 15)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 16)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 17)
+	  cisloTvaru += 1;
+	else if (cisloTvaru == 18)
+	  cisloTvaru -= 3;
+	return cisloTvaru;
+}
+
+
+static int refCell(int row, int col)
+{
+	return (board[row][col >> 1] >> ((col & 1) * 4)) & 0x0F;
+}
+
+// Funkcia vrati 1, ak sa tvar na pozicii x0, y0 zmesti do ramca a neprekryva ziadny polozeny objekt
+static int refBlockFits(int16_t x0, int16_t y0, int cisloTvaru){
+	int w, h;
+	refBlockSize(cisloTvaru, &w, &h);
+	for(int i = 0; i < w; i++)
+		for(int j = 0; j < h; j++){
+			if (!refBlockCell(cisloTvaru, i, j))
+				continue;
+			if (x0 + i < 0 || x0 + i >= BOARD_COLS || y0 - j >= BOARD_ROWS)
+				return 0;
+			if (y0 - j >= 0 && refCell(y0 - j, x0 + i) >= 2)
+				return 0;
+		}
+	return 1;
+}
+
+static int refDropRow(int16_t x0, int16_t y0, int cisloTvaru)
+{
+	while (refBlockFits(x0, y0 + 1, cisloTvaru))
+		y0++;
+	return y0;
+}
+
+static void mismatch(const char *check, int shape, int x, int y, int got, int expected)
+{
+	if (mismatches < 10)
+		printf("%s(x %d, y %d, shape %d) = %d, reference %d\n", check, x, y, shape, got, expected);
+	mismatches++;
+}
+
+// Every shape drawn on an empty board covers the reference cells
+static void testShapes(void)
+{
+	int w, h, cells;
+
+	for (int s = 0; s < SHAPES; s++)
+	{
+		CHECK_EQ(rotateObject(s), refRotateObject(s));
+
+		createFrame(board);
+		placeDownBlock(board, 3, 10, s);
+		refBlockSize(s, &w, &h);
+		cells = 0;
+		for (int row = 0; row < BOARD_ROWS; row++)
+			for (int col = 0; col < BOARD_COLS; col++)
+			{
+				int i = col - 3, j = 10 - row;
+				int inside = i >= 0 && i < w && j >= 0 && j < h && refBlockCell(s, i, j);
+
+				if ((refCell(row, col) != 0) != inside)
+					mismatch("cell", s, col, row, refCell(row, col) != 0, inside);
+				cells += inside;
+			}
+		CHECK_EQ(cells, 4);
+		checkLineFilled(board);
+	}
+}
+
+// Fill the board the way the game does: pieces dropped or left floating at
+// random fitting places, full rows cleared after every piece
+static void randomBoard(void)
+{
+	int pieces = nextRandom() % 60;
+	int s, x, y;
+
+	createFrame(board);
+	for (int k = 0; k < pieces; k++)
+	{
+		s = nextRandom() % SHAPES;
+		x = nextRandom() % BOARD_COLS;
+		if (!refBlockFits(x, -1, s))
+			continue;
+
+		y = refDropRow(x, -1, s);
+		if (nextRandom() % 4 == 0)
+			y = -1 + nextRandom() % (y + 2);
+		if (checkGameOver(board, x, y, s))
+			break;
+
+		placeDownBlock(board, x, y, s);
+		checkLineFilled(board);
+	}
+}
+
+// checkBlockade(y - 1) tests the bitboard fit at y itself, so every position
+// is compared; the moves are compared from every position the piece fits in
+static void compareBoard(uint32_t *positions)
+{
+	int fits;
+
+	for (int s = 0; s < SHAPES; s++)
+		for (int x = -1; x <= BOARD_COLS; x++)
+			for (int y = -1; y <= BOARD_ROWS; y++)
+			{
+				fits = refBlockFits(x, y, s);
+				if (checkBlockade(board, x, y - 1, s) != !fits)
+					mismatch("fits", s, x, y, !checkBlockade(board, x, y - 1, s), fits);
+				if (!fits)
+					continue;
+
+				(*positions)++;
+				if (checkBlockade(board, x, y, s) != !refBlockFits(x, y + 1, s))
+					mismatch("checkBlockade", s, x, y, checkBlockade(board, x, y, s), !refBlockFits(x, y + 1, s));
+				if (checkLeftSide(board, x, y, s) != !refBlockFits(x - 1, y, s))
+					mismatch("checkLeftSide", s, x, y, checkLeftSide(board, x, y, s), !refBlockFits(x - 1, y, s));
+				if (checkRightSide(board, x, y, s) != !refBlockFits(x + 1, y, s))
+					mismatch("checkRightSide", s, x, y, checkRightSide(board, x, y, s), !refBlockFits(x + 1, y, s));
+				if (checkRotation(board, x, y, s) != !refBlockFits(x, y, refRotateObject(s)))
+					mismatch("checkRotation", s, x, y, checkRotation(board, x, y, s), !refBlockFits(x, y, refRotateObject(s)));
+				if (dropRow(board, x, y, s) != refDropRow(x, y, s))
+					mismatch("dropRow", s, x, y, dropRow(board, x, y, s), refDropRow(x, y, s));
+			}
+}
+
+static double seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// All four checks from every position of every shape, bitboard against the
+// per-cell reference on the same board
+static void benchmark(void)
+{
+	volatile int sink = 0;
+	uint32_t checks = 0;
+	double start, bitboard, reference;
+
+	start = seconds();
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+		for (int s = 0; s < SHAPES; s++)
+			for (int x = 0; x < BOARD_COLS; x++)
+				for (int y = -1; y < BOARD_ROWS; y++)
+				{
+					sink += checkBlockade(board, x, y, s) + checkLeftSide(board, x, y, s);
+					sink += checkRightSide(board, x, y, s) + checkRotation(board, x, y, s);
+					checks += 4;
+				}
+	bitboard = seconds() - start;
+
+	start = seconds();
+	for (int r = 0; r < BENCH_ROUNDS; r++)
+		for (int s = 0; s < SHAPES; s++)
+			for (int x = 0; x < BOARD_COLS; x++)
+				for (int y = -1; y < BOARD_ROWS; y++)
+				{
+					sink += !refBlockFits(x, y + 1, s) + !refBlockFits(x - 1, y, s);
+					sink += !refBlockFits(x + 1, y, s) + !refBlockFits(x, y, refRotateObject(s));
+				}
+	reference = seconds() - start;
+
+	printf("collision checks: bitboard %.1f ns, per cell %.1f ns per check (%.1fx)\n",
+			bitboard * 1e9 / checks, reference * 1e9 / checks, reference / bitboard);
+}
+
+int main(void)
+{
+	uint32_t positions = 0;
+
+	testShapes();
+
+	createFrame(board);
+	compareBoard(&positions);
+	for (int b = 0; b < BOARDS; b++)
+	{
+		randomBoard();
+		compareBoard(&positions);
+	}
+	CHECK_EQ(mismatches, 0);
+	printf("collision checks: %u boards, %u fitting positions compared\n", BOARDS + 1, positions);
+
+	benchmark();
+
+	return checkReport("test_collision");
+}
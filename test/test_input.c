@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file    test/test_input.c
+  * @brief   The keypad median filter and classifier on the noisy trace of
+  *          the input benchmark, and the piece choice for seeds above
+  *          INT32_MAX.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include "check.h"
+#include "input.h"
+#include "ili9163.h"
+
+#define TRACE_TICKS	200
+
+// Ladder levels of none, left, none, right, down, none, rotate, none
+static const int16_t levels[] = { 4000, 2000, 4000, 2800, 3375, 4000, 3585, 4000 };
+#define LEVELS	(int)(sizeof(levels) / sizeof(levels[0]))
+
+// First shape and number of shapes of each piece, as in ili9163.c
+static const uint8_t pieces[7][2] = {
+	{ 0, 1 }, { 1, 2 }, { 3, 2 }, { 5, 2 }, { 7, 4 }, { 11, 4 }, { 15, 4 }
+};
+
+// One tick of the benchmark trace: +-40 noise and a +-600 spike in about
+// every 20th sample
+static void traceTick(int level, uint32_t *seed, volatile uint16_t *samples)
+{
+	int value;
+
+	for (int i = 0; i < INPUT_ADC_SAMPLES; i++)
+	{
+		*seed = *seed * 1103515245 + 12345;
+		value = level + (int)((*seed >> 16) % 81) - 40;
+		if ((*seed >> 8) % 20 == 0)
+			value += (*seed & 1) ? 600 : -600;
+		samples[i] = value < 0 ? 0 : (value > 4095 ? 4095 : value);
+	}
+}
+
+static void testMedian(void)
+{
+	static const uint16_t odd[] = { 5, 1, 4, 2, 3 };
+	static const uint16_t even[] = { 10, 40, 20, 30 };
+	static const uint16_t spikes[INPUT_ADC_SAMPLES] = {
+		2000, 2600, 2010, 1990, 2005, 1400, 2000, 1995,
+		2002, 2600, 1998, 2001, 1400, 2003, 1997, 2004
+	};
+	static const uint16_t one[] = { 1234 };
+
+	CHECK_EQ(inputMedian(odd, 5), 3);
+	CHECK_EQ(inputMedian(even, 4), 30);
+	CHECK_EQ(inputMedian(one, 1), 1234);
+	CHECK_EQ(inputMedian(spikes, INPUT_ADC_SAMPLES), 2001);
+}
+
+static void testClassify(void)
+{
+	CHECK_EQ(inputClassify(4000, INPUT_NONE), INPUT_NONE);
+	CHECK_EQ(inputClassify(2000, INPUT_NONE), INPUT_LEFT);
+	CHECK_EQ(inputClassify(2800, INPUT_NONE), INPUT_RIGHT);
+	CHECK_EQ(inputClassify(3375, INPUT_NONE), INPUT_DOWN);
+	CHECK_EQ(inputClassify(3585, INPUT_NONE), INPUT_ROTATE);
+	CHECK_EQ(inputClassify(1700, INPUT_NONE), INPUT_NONE);
+	CHECK_EQ(inputClassify(1701, INPUT_NONE), INPUT_LEFT);
+
+	// a held key keeps its band widened by the hysteresis
+	CHECK_EQ(inputClassify(1680, INPUT_LEFT), INPUT_LEFT);
+	CHECK_EQ(inputClassify(1670, INPUT_LEFT), INPUT_NONE);
+	CHECK_EQ(inputClassify(3460, INPUT_DOWN), INPUT_DOWN);
+	CHECK_EQ(inputClassify(3460, INPUT_NONE), INPUT_NONE);
+	// up to the gap between down and rotate, then rotate takes over
+	CHECK_EQ(inputClassify(3475, INPUT_DOWN), INPUT_DOWN);
+	CHECK_EQ(inputClassify(3530, INPUT_DOWN), INPUT_ROTATE);
+}
+
+// The benchmark trace: the median sees exactly the level changes, the raw
+// sample many more
+static void testTraceEdges(void)
+{
+	uint16_t samples[INPUT_ADC_SAMPLES];
+	uint32_t seed = 12345, expected = 0, raw = 0, median = 0;
+	uint8_t keyRaw = INPUT_NONE, keyMedian = INPUT_NONE, keyLevel = INPUT_NONE, key;
+
+	for (int l = 0; l < LEVELS; l++)
+	{
+		key = inputClassify(levels[l], INPUT_NONE);
+		expected += (key != keyLevel);
+		keyLevel = key;
+
+		for (int t = 0; t < TRACE_TICKS; t++)
+		{
+			traceTick(levels[l], &seed, samples);
+
+			key = inputClassify(samples[INPUT_ADC_SAMPLES - 1], keyRaw);
+			raw += (key != keyRaw);
+			keyRaw = key;
+
+			key = inputClassify(inputMedian(samples, INPUT_ADC_SAMPLES), keyMedian);
+			median += (key != keyMedian);
+			keyMedian = key;
+		}
+	}
+	CHECK_EQ(expected, 7);
+	CHECK_EQ(median, expected);
+	CHECK(raw > expected);
+}
+
+// The same trace through inputTick: one press per key and one release per
+// press, in order and debounced by a few ticks
+static void testTraceEvents(void)
+{
+	uint32_t seed = 12345, time = 0, start;
+	uint8_t heldLevel = INPUT_NONE, key;
+	InputEvent event;
+
+	inputFlush();
+	for (int l = 0; l < LEVELS; l++)
+	{
+		key = inputClassify(levels[l], INPUT_NONE);
+		start = time;
+		for (int t = 0; t < TRACE_TICKS; t++)
+		{
+			traceTick(levels[l], &seed, gAdcSamples);
+			inputTick(time++);
+		}
+
+		if (key != heldLevel && heldLevel != INPUT_NONE)
+		{
+			CHECK(inputPoll(&event));
+			CHECK_EQ(event.key, heldLevel);
+			CHECK_EQ(event.pressed, 0);
+			CHECK(event.time >= start && event.time < start + 10);
+		}
+		if (key != heldLevel && key != INPUT_NONE)
+		{
+			CHECK(inputPoll(&event));
+			CHECK_EQ(event.key, key);
+			CHECK_EQ(event.pressed, 1);
+			CHECK(event.time >= start && event.time < start + 10);
+		}
+		CHECK(!inputPoll(&event));
+		CHECK_EQ(inputHeld(), key);
+		heldLevel = key;
+	}
+}
+
+// Seeds above INT32_MAX, which gTicks reaches after about 24.8 days, still
+// pick one of the shapes of the chosen piece
+static void testGenerateNumber(void)
+{
+	static const uint32_t starts[] = { 0, 0x7FFFFF00u, 0xFFFFFF00u };
+	uint32_t seed;
+	int shape;
+
+	for (unsigned s = 0; s < sizeof(starts) / sizeof(starts[0]); s++)
+		for (uint32_t i = 0; i < 0x200; i++)
+		{
+			seed = starts[s] + i;
+			shape = generateNumber(seed);
+			CHECK(shape >= pieces[seed % 7][0] && shape < pieces[seed % 7][0] + pieces[seed % 7][1]);
+		}
+}
+
+int main(void)
+{
+	testMedian();
+	testClassify();
+	testTraceEdges();
+	testTraceEvents();
+	testGenerateNumber();
+	return checkReport("test_input");
+}
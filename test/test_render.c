@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file    test/test_render.c
+  * @brief   SPI bytes per frame of the playfield renderer: the full redraw
+  *          every frame used to send against the dirty rectangles it sends now,
+  *          and the HUD text on buffers without a byte to spare.
+  ******************************************************************************
+  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "check.h"
+#include "stub.h"
+#include "spidma.h"
+#include "ili9163.h"
+
+// lcdSetWindow(): three commands and eight parameters
+#define WINDOW_BYTES	11
+#define FULL_BYTES		(WINDOW_BYTES + (BOARD_COLS * CELL_SIZE + 2) * 128 * 2)
+// lcdPutCh(): one 6 x 8 glyph
+#define CHAR_BYTES		(WINDOW_BYTES + 6 * 8 * 2)
+
+static uint8_t board[BOARD_ROWS][BOARD_STRIDE];
+static int16_t pieceX, pieceY;
+static int piece;
+
+// Send the dirty rectangles, the result is the number of bytes on the bus
+static uint32_t frameBytes(void)
+{
+	uint32_t start = stubBytes;
+
+	matrixPlot(board, piece);
+	dmaWaitSPI2();
+	return stubBytes - start;
+}
+
+// One pass of gameUpdate(): the piece is erased for the ticks, moved and drawn again
+static uint32_t gamePass(int16_t x, int16_t y, int shape)
+{
+	createDeleteBlock(board, pieceX, pieceY, piece, 0);
+	pieceX = x;
+	pieceY = y;
+	piece = shape;
+	createDeleteBlock(board, pieceX, pieceY, piece, 1);
+	return frameBytes();
+}
+
+// Bytes of a w x h cell window
+static uint32_t cellBytes(int w, int h)
+{
+	return WINDOW_BYTES + w * CELL_SIZE * h * CELL_SIZE * 2;
+}
+
+// A size byte buffer that ends right before an unmapped page, reading
+// past it crashes the test
+static char *guardedBuffer(size_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	char *pages = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (pages == MAP_FAILED || mprotect(pages + page, page, PROT_NONE) != 0)
+	{
+		printf("render: no guard page\n");
+		exit(1);
+	}
+	return pages + page - size;
+}
+
+// updateText() with the 7 byte buffers of main.c filled up to the last byte
+static void testHud(void)
+{
+	char *scoreStr = guardedBuffer(7), *linesStr = guardedBuffer(7), *timeStr = guardedBuffer(7);
+	char *ppmStr = guardedBuffer(8);
+	int score = 999999, lines = 999999, time = 0, ppm = 0;
+	uint32_t start;
+
+	createText("NONAME ");
+	dmaWaitSPI2();
+	start = stubBytes;
+	updateText(&score, board, &lines, scoreStr, linesStr, &time, timeStr, &ppm, ppmStr, 999999);
+	dmaWaitSPI2();
+	CHECK_EQ(memcmp(scoreStr, "999999", 7), 0);
+	CHECK_EQ(memcmp(timeStr, "999999", 7), 0);
+	CHECK_EQ(memcmp(ppmStr, "60.0", 4), 0);
+	// six digits of score, lines and time and four characters of the rate
+	CHECK_EQ(stubBytes - start, (3 * 6 + 4) * CHAR_BYTES);
+
+	start = stubBytes;
+	updateText(&score, board, &lines, scoreStr, linesStr, &time, timeStr, &ppm, ppmStr, 999999);
+	dmaWaitSPI2();
+	CHECK_EQ(stubBytes - start, 0);
+}
+
+int main(void)
+{
+	uint32_t bytes, second;
+
+	stubReset();
+	initDmaSPI2();
+
+	// A new game redraws the whole playfield with its frame once, the way
+	// matrixPlot() used to do on every frame
+	createFrame(board);
+	pieceX = BLOCK_START_X;
+	pieceY = 5;
+	piece = 0;
+	createDeleteBlock(board, pieceX, pieceY, piece, 1);
+	bytes = frameBytes();
+	CHECK_EQ(bytes, FULL_BYTES);
+	CHECK_EQ(stubErrors, 0);
+
+	// The piece standing still costs nothing, however often the game runs
+	bytes = 0;
+	for (int i = 0; i < 1000; i++)
+		bytes += gamePass(pieceX, pieceY, piece);
+	CHECK_EQ(bytes, 0);
+
+	// One row down: the old and new squares merge into a 2 x 3 cell window
+	CHECK_EQ(gamePass(pieceX, pieceY + 1, piece), cellBytes(2, 3));
+
+	// One column right
+	CHECK_EQ(gamePass(pieceX + 1, pieceY, piece), cellBytes(3, 2));
+
+	// Rotation in place: | (1 x 4) to _ (4 x 1) covers a 4 x 4 window
+	gamePass(pieceX, pieceY, 1);
+	CHECK_EQ(gamePass(pieceX, pieceY, 2), cellBytes(4, 4));
+	CHECK_EQ(gamePass(pieceX, pieceY, 2), 0);
+
+	// One second at 1 kHz with the default gravity: ten rows down
+	second = 0;
+	for (int i = 0; i < 1000; i++)
+		second += gamePass(pieceX, pieceY + (i % 100 == 99), piece);
+	CHECK_EQ(second, 10 * cellBytes(4, 2));
+
+	// Clearing the bottom row only sends the two rows whose cells change
+	createDeleteBlock(board, pieceX, pieceY, piece, 0);
+	placeDownBlock(board, 0, BOARD_ROWS - 1, 2);
+	placeDownBlock(board, 4, BOARD_ROWS - 1, 2);
+	placeDownBlock(board, 8, BOARD_ROWS - 1, 0);
+	frameBytes();
+	CHECK_EQ(checkLineFilled(board), 100);
+	bytes = frameBytes();
+	CHECK_EQ(bytes, cellBytes(BOARD_COLS, 2));
+	CHECK(bytes < FULL_BYTES / 4);
+	CHECK_EQ(stubErrors, 0);
+
+	testHud();
+	CHECK_EQ(stubErrors, 0);
+
+	printf("render: full redraw %u bytes/frame, piece still 0, one row down %u, one second %u (was %u)\n",
+			FULL_BYTES, cellBytes(2, 3), second, 1000 * FULL_BYTES);
+
+	return checkReport("test_render");
+}
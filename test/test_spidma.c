@@ -0,0 +1,353 @@
+/**
+  ******************************************************************************
+  * @file    test/test_spidma.c
+  * @brief   Queueing, ordering and completion callbacks of mcu/spidma.c
+  *          against the simulated DMA1 channel 3 / SPI1.
+  ******************************************************************************
+  */
+
+#include <string.h>
+#include "check.h"
+#include "stm32l1xx.h"
+#include "stub.h"
+#include "spidma.h"
+#include "spi.h"
+
+#define LONG_PIXELS	0x10003
+
+static uint8_t bytesA[3] = {0xA0, 0xA1, 0xA2};
+static uint8_t bytesB[2] = {0xB0, 0xB1};
+static uint8_t single[20];
+static uint16_t pixels[3] = {0x1234, 0xF800, 0x07E0};
+static uint16_t longPixels[LONG_PIXELS];
+
+// Callbacks note their id and how many frames were on the bus by then
+static uint8_t callIds[64];
+static uint32_t callFrames[64];
+static uint32_t calls;
+
+static void noteCall(uint8_t id)
+{
+	callIds[calls] = id;
+	callFrames[calls] = stubFrameCount;
+	calls++;
+}
+
+static void callbackA(void)
+{
+	noteCall('A');
+}
+
+static void callbackB(void)
+{
+	noteCall('B');
+}
+
+static void callbackC(void)
+{
+	noteCall('C');
+}
+
+static void callbackQueueB(void)
+{
+	noteCall('A');
+	dmaWriteSPI2(bytesB, sizeof(bytesB), 0, callbackB);
+}
+
+static void setup(void)
+{
+	stubReset();
+	initDmaSPI2();
+	calls = 0;
+}
+
+static void checkIdle(void)
+{
+	CHECK_EQ(dmaBusySPI2(), 0);
+	CHECK_EQ(dmaQueuedSPI2(), 0);
+	CHECK_EQ(DMA1_Channel3->CCR & DMA_CCR1_EN, 0);
+	CHECK_EQ(stubErrors, 0);
+}
+
+static void checkFrame(uint32_t index, uint16_t value, uint8_t wide)
+{
+	CHECK(index < stubFrameCount);
+	CHECK_EQ(stubFrames[index].value, value);
+	CHECK_EQ(stubFrames[index].wide, wide);
+	CHECK_EQ(stubFrames[index].dma, 1);
+}
+
+static void testOrderAndCallbacks(void)
+{
+	setup();
+	CHECK(SPI1->CR2 & SPI_CR2_TXDMAEN);
+
+	dmaWriteSPI2(bytesA, sizeof(bytesA), 0, callbackA);
+	dmaFillSPI2(0x55, 2, 0, 0);
+	dmaWriteSPI2(bytesB, sizeof(bytesB), 0, callbackB);
+
+	// The first job goes on the bus right away, nothing has finished yet
+	CHECK_EQ(dmaBusySPI2(), 1);
+	CHECK_EQ(dmaQueuedSPI2(), 3);
+	CHECK(DMA1_Channel3->CCR & DMA_CCR1_EN);
+	CHECK_EQ(stubFrameCount, 0);
+	CHECK_EQ(calls, 0);
+
+	CHECK(stubDmaComplete());
+	CHECK_EQ(dmaQueuedSPI2(), 2);
+	CHECK_EQ(calls, 1);
+	CHECK_EQ(callIds[0], 'A');
+	CHECK_EQ(callFrames[0], 3);
+
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, 7);
+	checkFrame(0, 0xA0, 0);
+	checkFrame(1, 0xA1, 0);
+	checkFrame(2, 0xA2, 0);
+	checkFrame(3, 0x55, 0);
+	checkFrame(4, 0x55, 0);
+	checkFrame(5, 0xB0, 0);
+	checkFrame(6, 0xB1, 0);
+
+	CHECK_EQ(calls, 2);
+	CHECK_EQ(callIds[1], 'B');
+	CHECK_EQ(callFrames[1], 7);
+}
+
+// 20 jobs run the 8 slot ring over twice, the writer has to sleep while it is full
+static void testRingWrap(void)
+{
+	uint32_t i;
+
+	setup();
+	for (i = 0; i < sizeof(single); i++)
+	{
+		single[i] = i + 1;
+		dmaWriteSPI2(&single[i], 1, 0, callbackA);
+		CHECK(dmaQueuedSPI2() <= 7);
+	}
+	CHECK(dmaQueuedSPI2() >= 6);
+	CHECK(calls >= sizeof(single) - 7);
+
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, sizeof(single));
+	CHECK_EQ(calls, sizeof(single));
+	for (i = 0; i < sizeof(single); i++)
+	{
+		checkFrame(i, i + 1, 0);
+		CHECK_EQ(callFrames[i], i + 1);
+	}
+
+	// The ring is still usable after wrapping
+	dmaWriteSPI2(bytesB, sizeof(bytesB), 0, 0);
+	dmaWaitSPI2();
+	checkIdle();
+	checkFrame(sizeof(single), 0xB0, 0);
+	checkFrame(sizeof(single) + 1, 0xB1, 0);
+}
+
+// A repeated value must not leave the memory increment on for the next copy
+static void testFillThenCopy(void)
+{
+	uint32_t i;
+
+	setup();
+	dmaFillSPI2(0xF800, 5, SPI_DMA_16BIT, callbackA);
+	dmaWriteSPI2(pixels, 3, SPI_DMA_16BIT, callbackB);
+	CHECK_EQ(DMA1_Channel3->CCR & DMA_CCR1_MINC, 0);
+
+	CHECK(stubDmaComplete());
+	CHECK(DMA1_Channel3->CCR & DMA_CCR1_MINC);
+	CHECK_EQ(DMA1_Channel3->CMAR, (uint32_t)(uintptr_t)pixels);
+
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, 8);
+	for (i = 0; i < 5; i++)
+		checkFrame(i, 0xF800, 1);
+	for (i = 0; i < 3; i++)
+		checkFrame(5 + i, pixels[i], 1);
+	CHECK_EQ(calls, 2);
+	CHECK_EQ(callFrames[0], 5);
+	CHECK_EQ(callFrames[1], 8);
+}
+
+// Byte and pixel jobs queued back to back, the frame size may only change
+// between them (the stub counts a change during a transfer as an error)
+static void testFrameSizeChange(void)
+{
+	setup();
+	dmaWriteSPI2(bytesA, 2, 0, 0);
+	dmaFillSPI2(0x1234, 3, SPI_DMA_16BIT, 0);
+	dmaWriteSPI2(bytesB, 1, 0, 0);
+	dmaWriteSPI2(pixels, 1, SPI_DMA_16BIT, 0);
+
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, 7);
+	checkFrame(0, 0xA0, 0);
+	checkFrame(1, 0xA1, 0);
+	checkFrame(2, 0x1234, 1);
+	checkFrame(3, 0x1234, 1);
+	checkFrame(4, 0x1234, 1);
+	checkFrame(5, 0xB0, 0);
+	checkFrame(6, 0x1234, 1);
+	CHECK(SPI1->CR1 & SPI_CR1_DFF);
+	CHECK_EQ(stubBytes, 2 + 6 + 1 + 2);
+}
+
+// A callback runs in the interrupt and may queue the next job itself,
+// both when the queue ran empty and when other jobs are still waiting
+static void testCallbackQueuesJob(void)
+{
+	setup();
+	dmaWriteSPI2(bytesA, 1, 0, callbackQueueB);
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, 3);
+	checkFrame(0, 0xA0, 0);
+	checkFrame(1, 0xB0, 0);
+	checkFrame(2, 0xB1, 0);
+	CHECK_EQ(calls, 2);
+	CHECK_EQ(callIds[0], 'A');
+	CHECK_EQ(callIds[1], 'B');
+	CHECK_EQ(callFrames[1], 3);
+
+	setup();
+	dmaWriteSPI2(bytesA, 1, 0, callbackQueueB);
+	dmaWriteSPI2(&bytesA[2], 1, 0, callbackC);
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, 4);
+	checkFrame(0, 0xA0, 0);
+	checkFrame(1, 0xA2, 0);
+	checkFrame(2, 0xB0, 0);
+	checkFrame(3, 0xB1, 0);
+	CHECK_EQ(calls, 3);
+	CHECK_EQ(callIds[1], 'C');
+	CHECK_EQ(callIds[2], 'B');
+}
+
+// Transfers above the 16 bit DMA counter are split, only the last part
+// calls back
+static void testLongTransfer(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < LONG_PIXELS; i++)
+		longPixels[i] = i * 7;
+
+	setup();
+	dmaWriteSPI2(longPixels, LONG_PIXELS, SPI_DMA_16BIT, callbackA);
+	CHECK_EQ(dmaQueuedSPI2(), 2);
+	dmaFillSPI2(0xAB, 0x10001, 0, callbackB);
+	CHECK_EQ(dmaQueuedSPI2(), 4);
+
+	dmaWaitSPI2();
+	checkIdle();
+
+	CHECK_EQ(stubFrameCount, LONG_PIXELS + 0x10001);
+	for (i = 0; i < LONG_PIXELS; i++)
+	{
+		if (stubFrames[i].value != (uint16_t)(i * 7) || !stubFrames[i].wide)
+			break;
+	}
+	CHECK_EQ(i, LONG_PIXELS);
+	for (i = LONG_PIXELS; i < STUB_FRAMES && i < stubFrameCount; i++)
+	{
+		if (stubFrames[i].value != 0xAB || stubFrames[i].wide)
+			break;
+	}
+	CHECK_EQ(i, STUB_FRAMES);
+
+	CHECK_EQ(calls, 2);
+	CHECK_EQ(callFrames[0], LONG_PIXELS);
+	CHECK_EQ(callFrames[1], LONG_PIXELS + 0x10001);
+}
+
+// CS follows selecting jobs from the interrupt: held across consecutive
+// ones, released before a job without the flag and after the last one
+static void testSelect(void)
+{
+	uint32_t i;
+
+	setup();
+	dmaWriteSPI2(bytesA, sizeof(bytesA), SPI_DMA_SELECT, 0);
+	CHECK_EQ(stubSelected, 1);
+	dmaFillSPI2(0x1234, 2, SPI_DMA_16BIT | SPI_DMA_SELECT, callbackA);
+	dmaWriteSPI2(bytesB, sizeof(bytesB), 0, 0);
+	dmaWriteSPI2(bytesB, 1, SPI_DMA_SELECT, callbackB);
+
+	dmaWaitSPI2();
+	checkIdle();
+	CHECK_EQ(stubSelected, 0);
+
+	CHECK_EQ(stubFrameCount, 8);
+	for (i = 0; i < 5; i++)
+		CHECK_EQ(stubFrames[i].selected, 1);
+	CHECK_EQ(stubFrames[5].selected, 0);
+	CHECK_EQ(stubFrames[6].selected, 0);
+	CHECK_EQ(stubFrames[7].selected, 1);
+
+	// A job queued by the last callback is selected again
+	setup();
+	dmaWriteSPI2(bytesA, 1, SPI_DMA_SELECT, callbackA);
+	CHECK(stubDmaComplete());
+	CHECK_EQ(stubSelected, 0);
+	dmaWriteSPI2(bytesB, 1, SPI_DMA_SELECT, 0);
+	dmaWaitSPI2();
+	checkIdle();
+	CHECK_EQ(stubFrames[1].selected, 1);
+	CHECK_EQ(stubSelected, 0);
+}
+
+// Frames on the bus as the clock: a wait counts the frames it slept through
+static uint32_t frameClock(void)
+{
+	return stubFrameCount;
+}
+
+static void testSleepTime(void)
+{
+	uint32_t slept;
+
+	setup();
+	dmaSetClockSPI2(frameClock);
+	slept = dmaSleepSPI2();
+	dmaWaitSPI2();
+	CHECK_EQ(dmaSleepSPI2(), slept);
+
+	dmaWriteSPI2(bytesA, sizeof(bytesA), 0, 0);
+	dmaWriteSPI2(bytesB, sizeof(bytesB), 0, 0);
+	dmaWaitSPI2();
+	checkIdle();
+	CHECK_EQ(dmaSleepSPI2() - slept, sizeof(bytesA) + sizeof(bytesB));
+
+	dmaSetClockSPI2(0);
+	slept = dmaSleepSPI2();
+	dmaWriteSPI2(bytesA, sizeof(bytesA), 0, 0);
+	dmaWaitSPI2();
+	CHECK_EQ(dmaSleepSPI2(), slept);
+}
+
+int main(void)
+{
+	testOrderAndCallbacks();
+	testRingWrap();
+	testFillThenCopy();
+	testFrameSizeChange();
+	testCallbackQueuesJob();
+	testLongTransfer();
+	testSelect();
+	testSleepTime();
+
+	return checkReport("test_spidma");
+}
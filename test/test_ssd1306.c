@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    test/test_ssd1306.c
+  * @brief   Chip select and CD of the SSD1306 data blocks sent by DMA.
+  ******************************************************************************
+  */
+
+#include "check.h"
+#include "stub.h"
+#include "spidma.h"
+#include "ssd1306.h"
+
+static uint8_t block[0x80];
+
+int main(void)
+{
+	uint32_t i, blocks;
+
+	stubReset();
+	initDmaSPI2();
+	for (i = 0; i < sizeof(block); i++)
+		block[i] = i;
+
+	// A page of a picture: address instructions and queued data blocks
+	Set_Page_Address(0);
+	Set_Column_Address(0);
+	Write_Data_Block(block, sizeof(block));
+	Write_Data_Block(block, 8);
+	Write_Data_Block(block + 8, 8);
+	Set_Page_Address(1);
+	Write_Data_Block(block, 16);
+	dmaWaitSPI2();
+
+	CHECK_EQ(stubErrors, 0);
+	CHECK_EQ(stubSelected, 0);
+	CHECK_EQ(stubFrameCount, 3 + sizeof(block) + 8 + 8 + 1 + 16);
+
+	blocks = 0;
+	for (i = 0; i < stubFrameCount; i++)
+	{
+		CHECK_EQ(stubFrames[i].selected, 1);
+		CHECK_EQ(stubFrames[i].wide, 0);
+		CHECK_EQ(stubFrames[i].data, stubFrames[i].dma);
+		blocks += stubFrames[i].dma;
+	}
+	CHECK_EQ(blocks, sizeof(block) + 8 + 8 + 16);
+
+	return checkReport("test_ssd1306");
+}